@@ -50,6 +50,7 @@ static opl_driver_t *driver = NULL;
 static int init_stage_reg_writes = 1;
 
 unsigned int opl_sample_rate = 22050;
+int opl_render_threaded = 0;
 
 //
 // Init/shutdown code.
@@ -177,6 +178,13 @@ void OPL_SetSampleRate(unsigned int rate)
     opl_sample_rate = rate;
 }
 
+// Select whether software OPL emulation is rendered on its own thread.
+
+void OPL_SetRenderThread(int enabled)
+{
+    opl_render_threaded = enabled;
+}
+
 void OPL_WritePort(opl_port_t port, unsigned int value)
 {
     if (driver != NULL)
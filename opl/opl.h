@@ -85,6 +85,11 @@ void OPL_Shutdown(void);
 
 void OPL_SetSampleRate(unsigned int rate);
 
+// Render software emulation on a dedicated thread rather than in the
+// audio callback. Must be set before OPL_Init().
+
+void OPL_SetRenderThread(int enabled);
+
 // Write to one of the OPL I/O ports:
 
 void OPL_WritePort(opl_port_t port, unsigned int value);
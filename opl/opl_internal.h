@@ -54,6 +54,10 @@ typedef struct
 
 extern unsigned int opl_sample_rate;
 
+// If non-zero, software emulation runs on its own thread.
+
+extern int opl_render_threaded;
+
 
 #if (defined(__i386__) || defined(__x86_64__)) && defined(HAVE_IOPERM)
 extern opl_driver_t opl_linux_driver;
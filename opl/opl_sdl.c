@@ -39,6 +39,44 @@
 
 #define MAX_SOUND_SLICE_TIME 100 /* ms */
 
+// Render thread ring buffer size and the granularity (in samples) at
+// which the render thread generates output. Both must be powers of two.
+
+#define RENDER_RING_SAMPLES 4096
+#define RENDER_CHUNK_SAMPLES 64
+
+// Number of entries in the command ring; must be a power of two.
+
+#define COMMAND_RING_SIZE 1024
+
+// Commands sent from other threads to the output thread, which is the
+// only thread that touches the emulator and the callback queue.
+
+typedef enum
+{
+    OPL_CMD_WRITE_REGISTER,
+    OPL_CMD_SET_CALLBACK,
+    OPL_CMD_CLEAR_CALLBACKS,
+    OPL_CMD_ADJUST_CALLBACKS,
+} opl_command_type_t;
+
+typedef struct
+{
+    opl_command_type_t type;
+
+    // OPL_CMD_WRITE_REGISTER:
+    unsigned int reg_num;
+    unsigned int value;
+
+    // OPL_CMD_SET_CALLBACK; time is relative to when the command is run:
+    uint64_t us;
+    opl_callback_t callback;
+    void *data;
+
+    // OPL_CMD_ADJUST_CALLBACKS:
+    float factor;
+} opl_command_t;
+
 typedef struct
 {
     unsigned int rate;        // Number of times the timer is advanced per sec.
@@ -52,13 +90,33 @@ typedef struct
 
 static SDL_mutex *callback_mutex = NULL;
 
-// Queue of callbacks waiting to be invoked.
+// Queue of callbacks waiting to be invoked. Only ever accessed from the
+// output thread.
 
 static opl_callback_queue_t *callback_queue;
 
-// Mutex used to control access to the callback queue.
+// Single-producer/single-consumer ring of commands for the output thread.
+// Positions count commands ever written / read and wrap around freely.
+// Commands carry no timestamp: they take effect at the start of the next
+// segment the output thread renders. Only the control thread sends them
+// (starting, stopping and changing the volume of songs), and it has no
+// notion of the output sample clock to stamp them with; the register
+// writes that shape a song come from callbacks, which run on the output
+// thread at their exact sample positions.
+
+static opl_command_t command_ring[COMMAND_RING_SIZE];
+static SDL_atomic_t command_write_pos;
+static SDL_atomic_t command_read_pos;
 
-static SDL_mutex *callback_queue_mutex = NULL;
+// Set when OPL_Lock() kept the output thread from invoking callbacks;
+// the rest of the buffer is then rendered as if there were none due.
+
+static int callbacks_deferred;
+
+// Thread generating OPL output: either the audio callback thread or
+// the render thread. Callbacks run here and may act directly.
+
+static SDL_threadID output_thread_id;
 
 // Current time, in us since startup:
 
@@ -82,15 +140,37 @@ static int opl_opl3mode;
 
 static uint8_t *mix_buffer = NULL;
 
-// Register number that was written.
+// Register number that was written, from the output thread and from
+// any other thread.
 
 static int register_num = 0;
+static int output_register_num = 0;
 
 // Timers; DBOPL does not do timer stuff itself.
 
 static opl_timer_t timer1 = { 12500, 0, 0, 0 };
 static opl_timer_t timer2 = { 3125, 0, 0, 0 };
 
+// Render thread state. When the render thread is running, it owns the
+// emulator and the callback queue timeline, generating output ahead of
+// time into a single-producer/single-consumer ring buffer. The mixing
+// callback then only has to mix already-rendered samples.
+
+static SDL_Thread *render_thread = NULL;
+static SDL_sem *render_sem = NULL;
+static SDL_atomic_t render_running;
+static Bit16s *render_ring = NULL;
+
+// Total samples written to / read from the ring; wrap around freely.
+
+static SDL_atomic_t render_write_pos;
+static SDL_atomic_t render_read_pos;
+
+// How many samples the render thread keeps ready ahead of the mixing
+// callback; adjusted to the size of the audio buffer.
+
+static SDL_atomic_t render_target;
+
 // SDL parameters.
 
 static int sdl_was_initialized = 0;
@@ -105,6 +185,79 @@ static int SDLIsInitialized(void)
     return Mix_QuerySpec(&freq, &format, &channels);
 }
 
+// Returns true if the calling thread is the output thread.
+
+static int OnOutputThread(void)
+{
+    return SDL_ThreadID() == output_thread_id;
+}
+
+// Hand a command to the output thread.
+
+static void SendCommand(const opl_command_t *cmd)
+{
+    unsigned int write_pos;
+
+    write_pos = SDL_AtomicGet(&command_write_pos);
+
+    // The output thread empties the ring every time it renders, so this
+    // should only ever wait very briefly. It never waits for OPL_Lock()
+    // in order to do so, so this is safe while holding the lock.
+
+    while (write_pos - SDL_AtomicGet(&command_read_pos) >= COMMAND_RING_SIZE)
+    {
+        SDL_Delay(1);
+    }
+
+    SDL_MemoryBarrierAcquire();
+    command_ring[write_pos & (COMMAND_RING_SIZE - 1)] = *cmd;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&command_write_pos, write_pos + 1);
+}
+
+// Run all commands that have been sent to the output thread.
+
+static void RunCommands(void)
+{
+    unsigned int read_pos, write_pos;
+    opl_command_t *cmd;
+
+    read_pos = SDL_AtomicGet(&command_read_pos);
+    write_pos = SDL_AtomicGet(&command_write_pos);
+    SDL_MemoryBarrierAcquire();
+
+    while (read_pos != write_pos)
+    {
+        cmd = &command_ring[read_pos & (COMMAND_RING_SIZE - 1)];
+
+        switch (cmd->type)
+        {
+            case OPL_CMD_WRITE_REGISTER:
+                OPL3_WriteRegBuffered(&opl_chip, cmd->reg_num, cmd->value);
+                break;
+
+            case OPL_CMD_SET_CALLBACK:
+                OPL_Queue_Push(callback_queue, cmd->callback, cmd->data,
+                               current_time - pause_offset + cmd->us);
+                break;
+
+            case OPL_CMD_CLEAR_CALLBACKS:
+                OPL_Queue_Clear(callback_queue);
+                break;
+
+            case OPL_CMD_ADJUST_CALLBACKS:
+                OPL_Queue_AdjustCallbacks(callback_queue, current_time,
+                                          cmd->factor);
+                break;
+        }
+
+        ++read_pos;
+    }
+
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&command_read_pos, read_pos);
+}
+
 // Advance time by the specified number of samples, invoking any
 // callback functions as appropriate.
 
@@ -114,8 +267,6 @@ static void AdvanceTime(unsigned int nsamples)
     void *callback_data;
     uint64_t us;
 
-    SDL_LockMutex(callback_queue_mutex);
-
     // Advance time.
 
     us = ((uint64_t) nsamples * OPL_SECOND) / mixing_freq;
@@ -132,72 +283,64 @@ static void AdvanceTime(unsigned int nsamples)
     while (!OPL_Queue_IsEmpty(callback_queue)
         && current_time >= OPL_Queue_Peek(callback_queue) + pause_offset)
     {
-        // Pop the callback from the queue to invoke it.
-
-        if (!OPL_Queue_Pop(callback_queue, &callback, &callback_data))
+        // We must hold callback_mutex when we invoke the callback, so
+        // that the control thread can use OPL_Lock() to prevent callbacks
+        // from being invoked. Anything it sent while holding the lock
+        // (eg. clearing the queue) must be run before we go ahead.
+        // Don't wait for it though: the control thread may itself be
+        // waiting in SendCommand() for us to empty the command ring.
+
+        if (SDL_TryLockMutex(callback_mutex) != 0)
         {
+            callbacks_deferred = 1;
             break;
         }
 
-        // The mutex stuff here is a bit complicated.  We must
-        // hold callback_mutex when we invoke the callback (so that
-        // the control thread can use OPL_Lock() to prevent callbacks
-        // from being invoked), but we must not be holding
-        // callback_queue_mutex, as the callback must be able to
-        // call OPL_SetCallback to schedule new callbacks.
+        RunCommands();
 
-        SDL_UnlockMutex(callback_queue_mutex);
+        if (OPL_Queue_IsEmpty(callback_queue)
+         || current_time < OPL_Queue_Peek(callback_queue) + pause_offset
+         || !OPL_Queue_Pop(callback_queue, &callback, &callback_data))
+        {
+            SDL_UnlockMutex(callback_mutex);
+            break;
+        }
 
-        SDL_LockMutex(callback_mutex);
         callback(callback_data);
         SDL_UnlockMutex(callback_mutex);
-
-        SDL_LockMutex(callback_queue_mutex);
     }
-
-    SDL_UnlockMutex(callback_queue_mutex);
 }
 
-// Call the OPL emulator code to fill the specified buffer.
+// Call the OPL emulator code to generate the specified number of samples
+// into a buffer, invoking callbacks at the right points in time.
 
-static void FillBuffer(uint8_t *buffer, unsigned int nsamples)
+static void RenderSamples(Bit16s *buffer, unsigned int buffer_samples)
 {
-    // This seems like a reasonable assumption.  mix_buffer is
-    // 1 second long, which should always be much longer than the
-    // SDL mix buffer.
-    assert(nsamples < mixing_freq);
-
-    // OPL output is generated into temporary buffer and then mixed
-    // (to avoid overflows etc.)
-    OPL3_GenerateStream(&opl_chip, (Bit16s *) mix_buffer, nsamples);
-    SDL_MixAudioFormat(buffer, mix_buffer, AUDIO_S16SYS, nsamples * 4,
-                       SDL_MIX_MAXVOLUME);
-}
+    unsigned int filled;
 
-// Callback function to fill a new sound buffer:
-
-static void OPL_Mix_Callback(int chan, void *stream, int len, void *udata)
-{
-    unsigned int filled, buffer_samples;
-    Uint8 *buffer = (Uint8*)stream;
+    output_thread_id = SDL_ThreadID();
 
     // Repeatedly call the OPL emulator update function until the buffer is
     // full.
     filled = 0;
-    buffer_samples = len / 4;
+    callbacks_deferred = 0;
 
     while (filled < buffer_samples)
     {
         uint64_t next_callback_time;
         uint64_t nsamples;
 
-        SDL_LockMutex(callback_queue_mutex);
+        // Apply register writes and callback changes sent since the
+        // last segment, so that they take effect at this sample.
+
+        RunCommands();
 
         // Work out the time until the next callback waiting in
         // the callback queue must be invoked.  We can then fill the
         // buffer with this many samples.
 
-        if (opl_sdl_paused || OPL_Queue_IsEmpty(callback_queue))
+        if (opl_sdl_paused || callbacks_deferred
+         || OPL_Queue_IsEmpty(callback_queue))
         {
             nsamples = buffer_samples - filled;
         }
@@ -214,11 +357,9 @@ static void OPL_Mix_Callback(int chan, void *stream, int len, void *udata)
             }
         }
 
-        SDL_UnlockMutex(callback_queue_mutex);
-
         // Add emulator output to buffer.
 
-        FillBuffer(buffer + filled * 4, nsamples);
+        OPL3_GenerateStream(&opl_chip, buffer + filled * 2, nsamples);
         filled += nsamples;
 
         // Invoke callbacks for this point in time.
@@ -227,9 +368,158 @@ static void OPL_Mix_Callback(int chan, void *stream, int len, void *udata)
     }
 }
 
+// Mix samples from the render thread's ring buffer into the output.
+
+static void MixFromRing(Uint8 *buffer, unsigned int buffer_samples)
+{
+    unsigned int read_pos, available, offset, n;
+    unsigned int target;
+
+    // Keep two audio buffers' worth rendered ahead, so that the render
+    // thread never has to catch up from behind.
+
+    target = (buffer_samples * 2 + RENDER_CHUNK_SAMPLES - 1)
+           & ~(RENDER_CHUNK_SAMPLES - 1);
+    if (target > RENDER_RING_SAMPLES)
+    {
+        target = RENDER_RING_SAMPLES;
+    }
+    SDL_AtomicSet(&render_target, target);
+
+    read_pos = SDL_AtomicGet(&render_read_pos);
+    available = SDL_AtomicGet(&render_write_pos) - read_pos;
+    SDL_MemoryBarrierAcquire();
+
+    if (available > buffer_samples)
+    {
+        available = buffer_samples;
+    }
+
+    // Copy out in at most two pieces, as the data may wrap around the
+    // end of the ring. Anything the render thread hasn't produced yet
+    // is left silent.
+
+    while (available > 0)
+    {
+        offset = read_pos & (RENDER_RING_SAMPLES - 1);
+        n = RENDER_RING_SAMPLES - offset;
+        if (n > available)
+        {
+            n = available;
+        }
+
+        SDL_MixAudioFormat(buffer, (Uint8 *) (render_ring + offset * 2),
+                           AUDIO_S16SYS, n * 4, SDL_MIX_MAXVOLUME);
+
+        buffer += n * 4;
+        read_pos += n;
+        available -= n;
+    }
+
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&render_read_pos, read_pos);
+    SDL_SemPost(render_sem);
+}
+
+// Render thread main loop: keep the ring topped up to the target level.
+
+static int RenderThread(void *unused)
+{
+    unsigned int write_pos, ahead;
+
+    while (SDL_AtomicGet(&render_running))
+    {
+        write_pos = SDL_AtomicGet(&render_write_pos);
+        ahead = write_pos - SDL_AtomicGet(&render_read_pos);
+        SDL_MemoryBarrierAcquire();
+
+        if (ahead + RENDER_CHUNK_SAMPLES > SDL_AtomicGet(&render_target))
+        {
+            // Wait until the mixing callback has consumed some more.
+
+            SDL_SemWaitTimeout(render_sem, 10);
+            continue;
+        }
+
+        RenderSamples(render_ring
+                        + (write_pos & (RENDER_RING_SAMPLES - 1)) * 2,
+                      RENDER_CHUNK_SAMPLES);
+
+        SDL_MemoryBarrierRelease();
+        SDL_AtomicSet(&render_write_pos, write_pos + RENDER_CHUNK_SAMPLES);
+    }
+
+    return 0;
+}
+
+static void StartRenderThread(void)
+{
+    render_ring = malloc(RENDER_RING_SAMPLES * 4);
+    render_sem = SDL_CreateSemaphore(0);
+    SDL_AtomicSet(&render_write_pos, 0);
+    SDL_AtomicSet(&render_read_pos, 0);
+    SDL_AtomicSet(&render_target, RENDER_CHUNK_SAMPLES * 4);
+    SDL_AtomicSet(&render_running, 1);
+
+    render_thread = SDL_CreateThread(RenderThread, "OPL render", NULL);
+
+    if (render_thread == NULL)
+    {
+        fprintf(stderr, "OPL_SDL: Failed to start render thread: %s\n",
+                SDL_GetError());
+        SDL_DestroySemaphore(render_sem);
+        render_sem = NULL;
+        free(render_ring);
+        render_ring = NULL;
+    }
+}
+
+static void StopRenderThread(void)
+{
+    if (render_thread != NULL)
+    {
+        SDL_AtomicSet(&render_running, 0);
+        SDL_SemPost(render_sem);
+        SDL_WaitThread(render_thread, NULL);
+        render_thread = NULL;
+
+        SDL_DestroySemaphore(render_sem);
+        render_sem = NULL;
+        free(render_ring);
+        render_ring = NULL;
+    }
+}
+
+// Callback function to fill a new sound buffer:
+
+static void OPL_Mix_Callback(int chan, void *stream, int len, void *udata)
+{
+    unsigned int buffer_samples = len / 4;
+
+    if (render_thread != NULL)
+    {
+        MixFromRing((Uint8 *) stream, buffer_samples);
+        return;
+    }
+
+    // This seems like a reasonable assumption.  mix_buffer is
+    // 1 second long, which should always be much longer than the
+    // SDL mix buffer.
+    assert(buffer_samples < mixing_freq);
+
+    // OPL output is generated into temporary buffer and then mixed
+    // (to avoid overflows etc.)
+    RenderSamples((Bit16s *) mix_buffer, buffer_samples);
+    SDL_MixAudioFormat((Uint8 *) stream, mix_buffer, AUDIO_S16SYS,
+                       buffer_samples * 4, SDL_MIX_MAXVOLUME);
+}
+
 static void OPL_SDL_Shutdown(void)
 {
     Mix_HookMusic(NULL, NULL);
+    Mix_UnregisterEffect(MIX_CHANNEL_POST, OPL_Mix_Callback);
+
+    StopRenderThread();
 
     if (sdl_was_initialized)
     {
@@ -254,11 +544,6 @@ static void OPL_SDL_Shutdown(void)
         callback_mutex = NULL;
     }
 
-    if (callback_queue_mutex != NULL)
-    {
-        SDL_DestroyMutex(callback_queue_mutex);
-        callback_queue_mutex = NULL;
-    }
 }
 
 static unsigned int GetSliceSize(void)
@@ -325,6 +610,8 @@ static int OPL_SDL_Init(unsigned int port_base)
 
     callback_queue = OPL_Queue_Create();
     current_time = 0;
+    SDL_AtomicSet(&command_write_pos, 0);
+    SDL_AtomicSet(&command_read_pos, 0);
 
     // Get the mixer frequency, format and number of channels.
 
@@ -351,7 +638,11 @@ static int OPL_SDL_Init(unsigned int port_base)
     opl_opl3mode = 0;
 
     callback_mutex = SDL_CreateMutex();
-    callback_queue_mutex = SDL_CreateMutex();
+
+    if (opl_render_threaded)
+    {
+        StartRenderThread();
+    }
 
     // Set postmix that adds the OPL music. This is deliberately done
     // as a postmix and not using Mix_HookMusic() as the latter disables
@@ -441,41 +732,77 @@ static void WriteRegister(unsigned int reg_num, unsigned int value)
             opl_opl3mode = value & 0x01;
 
         default:
-            OPL3_WriteRegBuffered(&opl_chip, reg_num, value);
+            if (OnOutputThread())
+            {
+                OPL3_WriteRegBuffered(&opl_chip, reg_num, value);
+            }
+            else
+            {
+                opl_command_t cmd;
+
+                cmd.type = OPL_CMD_WRITE_REGISTER;
+                cmd.reg_num = reg_num;
+                cmd.value = value;
+                SendCommand(&cmd);
+            }
             break;
     }
 }
 
 static void OPL_SDL_PortWrite(opl_port_t port, unsigned int value)
 {
+    int *reg;
+
+    // Callbacks on the output thread can write registers at the same time
+    // as the main thread, so each needs its own register number latch.
+
+    reg = OnOutputThread() ? &output_register_num : &register_num;
+
     if (port == OPL_REGISTER_PORT)
     {
-        register_num = value;
+        *reg = value;
     }
     else if (port == OPL_REGISTER_PORT_OPL3)
     {
-        register_num = value | 0x100;
+        *reg = value | 0x100;
     }
     else if (port == OPL_DATA_PORT)
     {
-        WriteRegister(register_num, value);
+        WriteRegister(*reg, value);
     }
 }
 
 static void OPL_SDL_SetCallback(uint64_t us, opl_callback_t callback,
                                 void *data)
 {
-    SDL_LockMutex(callback_queue_mutex);
-    OPL_Queue_Push(callback_queue, callback, data,
-                   current_time - pause_offset + us);
-    SDL_UnlockMutex(callback_queue_mutex);
+    opl_command_t cmd;
+
+    if (OnOutputThread())
+    {
+        OPL_Queue_Push(callback_queue, callback, data,
+                       current_time - pause_offset + us);
+        return;
+    }
+
+    cmd.type = OPL_CMD_SET_CALLBACK;
+    cmd.us = us;
+    cmd.callback = callback;
+    cmd.data = data;
+    SendCommand(&cmd);
 }
 
 static void OPL_SDL_ClearCallbacks(void)
 {
-    SDL_LockMutex(callback_queue_mutex);
-    OPL_Queue_Clear(callback_queue);
-    SDL_UnlockMutex(callback_queue_mutex);
+    opl_command_t cmd;
+
+    if (OnOutputThread())
+    {
+        OPL_Queue_Clear(callback_queue);
+        return;
+    }
+
+    cmd.type = OPL_CMD_CLEAR_CALLBACKS;
+    SendCommand(&cmd);
 }
 
 static void OPL_SDL_Lock(void)
@@ -495,9 +822,17 @@ static void OPL_SDL_SetPaused(int paused)
 
 static void OPL_SDL_AdjustCallbacks(float factor)
 {
-    SDL_LockMutex(callback_queue_mutex);
-    OPL_Queue_AdjustCallbacks(callback_queue, current_time, factor);
-    SDL_UnlockMutex(callback_queue_mutex);
+    opl_command_t cmd;
+
+    if (OnOutputThread())
+    {
+        OPL_Queue_AdjustCallbacks(callback_queue, current_time, factor);
+        return;
+    }
+
+    cmd.type = OPL_CMD_ADJUST_CALLBACKS;
+    cmd.factor = factor;
+    SendCommand(&cmd);
 }
 
 opl_driver_t opl_sdl_driver =
@@ -23,6 +23,7 @@
 #include "d_loop.h"
 #include "d_ticcmd.h"
 
+#include "i_pacer.h"
 #include "i_system.h"
 #include "i_timer.h"
 #include "i_video.h"
@@ -302,9 +303,34 @@ void D_ReceiveTic(ticcmd_t *ticcmds, boolean *players_mask)
 // Called after the screen is set but before the game starts running.
 //
 
+// [crispy] Called by the frame rate limiter while it waits: build any
+// tics that have become due, and return the number of us until the
+// next one is.
+
+static uint64_t PacerUpdate(void)
+{
+    int time_ms, next_tic_ms;
+
+    NetUpdate();
+
+    time_ms = I_GetTimeMS();
+
+    if (new_sync)
+    {
+        time_ms += (offsetms / FRACUNIT);
+    }
+
+    next_tic_ms = ((GetAdjustedTime() / ticdup + 1) * ticdup * 1000
+                   + TICRATE - 1) / TICRATE;
+
+    return next_tic_ms > time_ms ? (next_tic_ms - time_ms) * 1000ull : 0;
+}
+
 void D_StartGameLoop(void)
 {
     lasttime = GetAdjustedTime() / ticdup;
+
+    I_PacerSetCallback(PacerUpdate);
 }
 
 //
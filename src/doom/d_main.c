@@ -69,6 +69,7 @@
 #include "wi_stuff.h"
 #include "st_stuff.h"
 #include "am_map.h"
+#include "net_bench.h"
 #include "net_client.h"
 #include "net_dedicated.h"
 #include "net_query.h"
@@ -129,6 +130,9 @@ boolean         storedemo;
 // If true, the main game loop has started.
 boolean         main_loop_started = false;
 
+// [crispy] Simulate a demo without window, sound or renderer.
+boolean         headless = false;
+
 char		wadfile[1024];		// primary wad file
 char		mapdir[1024];           // directory of development maps
 
@@ -572,6 +576,45 @@ void D_RunFrame()
 	}
 }
 
+//
+// D_HeadlessLoop
+// [crispy] Run the game tics back to back. Nothing is drawn or played and
+// no events are read, so this only ends with the demo.
+//
+static uint64_t headlessstart;
+
+static void D_HeadlessReport (void)
+{
+    const uint64_t elapsed = I_GetTimeUS() - headlessstart;
+
+    printf("Headless: %d gametics in %.3f seconds (%.1f tics per second)\n",
+           gametic, elapsed / 1000000.0,
+           elapsed ? gametic * 1000000.0 / elapsed : 0.0);
+}
+
+static void D_HeadlessLoop (void)
+{
+    static ticcmd_t cmds[MAXPLAYERS];
+
+    // the demo overwrites these with its own ticcmds in G_Ticker()
+    netcmds = cmds;
+
+    nodrawers = true;
+    singletics = true;
+
+    I_AtExit(D_HeadlessReport, true);
+    headlessstart = I_GetTimeUS();
+
+    while (1)
+    {
+        if (advancedemo)
+            D_DoAdvanceDemo ();
+
+        G_Ticker ();
+        gametic++;
+    }
+}
+
 //
 //  D_DoomLoop
 //
@@ -590,6 +633,11 @@ void D_DoomLoop (void)
     if (demorecording && gameaction != ga_playdemo)
 	G_BeginRecording ();
 
+    if (headless)
+    {
+        D_HeadlessLoop ();  // never returns
+    }
+
     main_loop_started = true;
 
     I_SetWindowTitle(gamedescription);
@@ -1490,6 +1538,22 @@ void D_DoomMain (void)
         // Never returns
     }
 
+    //!
+    // @category net
+    // @arg <n>
+    //
+    // Run a network benchmark: start a server and n scripted clients
+    // in this process, connected through a simulated network, and
+    // report tic throughput, resends and latency.
+    //
+
+    if (M_CheckParmWithArgs("-netbench", 1) > 0)
+    {
+        NET_Benchmark();
+
+        // Never returns
+    }
+
     //!
     // @category net
     //
@@ -2014,6 +2078,26 @@ void D_DoomMain (void)
         printf("Playing demo %s.\n", file);
     }
 
+    //!
+    // @category demo
+    //
+    // Play back the demo given with -playdemo or -timedemo as fast as
+    // possible, without opening a window, initializing sound or setting
+    // up the renderer, and print the number of tics simulated per second.
+    // Useful together with -statdump.
+    //
+
+    if (M_ParmExists("-headless"))
+    {
+        if (!p || M_ParmExists("-record"))
+        {
+            I_Error("The -headless option requires -playdemo or -timedemo\n"
+                    "and can not be used with -record.");
+        }
+
+        headless = true;
+    }
+
     I_AtExit(G_CheckDemoStatusAtExit, true);
 
     // Generate the WAD hash table.  Speed things up a bit.
@@ -2148,8 +2232,12 @@ void D_DoomMain (void)
     I_CheckIsScreensaver();
     I_InitTimer();
     I_InitJoystick();
-    I_InitSound(true);
-    I_InitMusic();
+    // [crispy] -headless stubs out the sound code
+    if (!headless)
+    {
+        I_InitSound(true);
+        I_InitMusic();
+    }
 
     // [crispy] check for SSG resources
     crispy->havessg =
@@ -2369,14 +2457,26 @@ void D_DoomMain (void)
     DEH_printf("M_Init: Init miscellaneous info.\n");
     M_Init ();
 
-    DEH_printf("R_Init: Init DOOM refresh daemon - ");
-    R_Init ();
+    // [crispy] without a renderer, only load what the playsim needs
+    if (headless)
+    {
+        DEH_printf("R_InitPlaysimData: Init textures and flats - ");
+        R_InitPlaysimData ();
+    }
+    else
+    {
+        DEH_printf("R_Init: Init DOOM refresh daemon - ");
+        R_Init ();
+    }
 
     DEH_printf("\nP_Init: Init Playloop state.\n");
     P_Init ();
 
-    DEH_printf("S_Init: Setting up sound.\n");
-    S_Init (sfxVolume * 8, musicVolume * 8);
+    if (!headless)
+    {
+        DEH_printf("S_Init: Setting up sound.\n");
+        S_Init (sfxVolume * 8, musicVolume * 8);
+    }
 
     DEH_printf("D_CheckNetGame: Checking network game status.\n");
     D_CheckNetGame ();
@@ -22,6 +22,7 @@
 
 #include "info.h"
 
+#include "deh_bexptr.h"
 #include "deh_io.h"
 #include "deh_main.h"
 
@@ -269,6 +270,23 @@ static void DEH_BEXPtrParseLine(deh_context_t *context, char *line, void *tag)
     DEH_Warning(context, "Invalid mnemonic '%s'", value);
 }
 
+// [crispy] mnemonic of a code pointer, or NULL if it is not in the
+// table; used by the playsim profiler
+const char *DEH_BEXCodePointerName(actionf_t pointer)
+{
+    int i;
+
+    for (i = 0; i < arrlen(bex_codeptrtable); i++)
+    {
+        if (bex_codeptrtable[i].pointer.acv == pointer.acv)
+        {
+            return bex_codeptrtable[i].mnemonic;
+        }
+    }
+
+    return NULL;
+}
+
 deh_section_t deh_section_bexptr =
 {
     "[CODEPTR]",
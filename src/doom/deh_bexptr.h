@@ -0,0 +1,26 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+// Copyright(C) 2014 Fabian Greffrath
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+//
+// Parses [CODEPTR] sections in BEX files
+//
+
+#ifndef DEH_BEXPTR_H
+#define DEH_BEXPTR_H
+
+#include "d_think.h"
+
+extern const char *DEH_BEXCodePointerName (actionf_t pointer);
+
+#endif /* #ifndef DEH_BEXPTR_H */
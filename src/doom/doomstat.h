@@ -146,6 +146,7 @@ extern  boolean	paused;		// Game Pause?
 extern  boolean		viewactive;
 
 extern  boolean		nodrawers;
+extern  boolean		headless; // [crispy]
 
 
 extern  boolean         testcontrols;
@@ -260,6 +261,9 @@ extern  int             mouseSensitivity;
 extern  int             mouseSensitivity_x2;
 extern  int             mouseSensitivity_y;
 
+#define BODYQUESIZE	32
+
+extern  mobj_t*         bodyque[BODYQUESIZE];
 extern  int             bodyqueslot;
 
 
@@ -275,6 +279,7 @@ extern int		skyflatnum;
 
 
 extern	int		rndindex;
+extern	int		prndindex; // [crispy]
 
 extern  ticcmd_t       *netcmds;
 
@@ -46,6 +46,8 @@
 #include "p_saveg.h"
 #include "p_extsaveg.h"
 #include "p_tick.h"
+#include "p_profile.h" // [crispy] playsim profiler
+#include "p_snapshot.h" // [crispy] demo seeking
 
 #include "d_main.h"
 
@@ -95,6 +97,11 @@ void	G_DoCompleted (void);
 void	G_DoVictory (void); 
 void	G_DoWorldDone (void); 
 void	G_DoSaveGame (void); 
+
+// [crispy] demo seeking
+static boolean G_DemoSeekResponder (event_t* ev);
+static void G_DemoSeekTicker (void);
+static void G_ClearDemoSnapshots (void);
  
 // Gamestate the last time G_Ticker was called.
 
@@ -250,8 +257,6 @@ static char     savename[256]; // [crispy] moved here, made static
 static int      savegameslot; 
 static char     savedescription[32]; 
  
-#define	BODYQUESIZE	32
-
 mobj_t*		bodyque[BODYQUESIZE]; 
 int		bodyqueslot; 
  
@@ -1088,6 +1093,12 @@ boolean G_Responder (event_t* ev)
         singletics = !singletics;
         return true;
     }
+
+    // [crispy] demo seeking
+    if (G_DemoSeekResponder(ev))
+    {
+        return true;
+    }
  
     // allow spy mode changes even during the demo
     if (gamestate == GS_LEVEL && ev->type == ev_keydown 
@@ -1308,6 +1319,12 @@ void G_Ticker (void)
 	} 
     }
     
+    // [crispy] demo seeking
+    if (demoplayback && gameaction == ga_nothing)
+    {
+        G_DemoSeekTicker();
+    }
+
     // [crispy] demo sync of revenant tracers and RNG (from prboom-plus)
     if (paused & 2 || (!demoplayback && menuactive && !netgame))
     {
@@ -2355,6 +2372,235 @@ void G_DoLoadGame (void)
     // the next savegame will be loaded from the menu
     startloadgame = -1;
 } 
+
+
+//
+// [crispy] DEMO SEEKING
+// While a demo from the command line plays, snapshot the level every
+// SNAPSHOTINTERVAL tics.  A seek restores the last snapshot before the
+// target and plays on from there without drawing.
+//
+
+#define SNAPSHOTINTERVAL	(30*TICRATE)
+#define SEEKSTEP		(10*TICRATE)
+
+typedef struct
+{
+    int		tic;		// defdemotics when it was taken
+    int		demopos;	// offset of demo_p into demobuffer
+    int		starttic;	// gametic - demostarttic
+    int		paused;
+    snapshot_t*	snapshot;
+} demosnapshot_t;
+
+static demosnapshot_t*	demosnapshots;
+static int		numdemosnapshots;
+static int		maxdemosnapshots;
+
+static int		demoseektic;
+static boolean		demoseekpending;
+static boolean		demoseeking;	// fast-forwarding to demoseektic
+static boolean		seeknodrawers;
+static boolean		seeksingletics;
+
+static boolean G_CanSeekDemo (void)
+{
+    return demoplayback && singledemo && !demorecording && !timingdemo;
+}
+
+static void G_StopDemoSeek (void)
+{
+    if (demoseeking)
+    {
+	nodrawers = seeknodrawers;
+	singletics = seeksingletics;
+	demoseeking = false;
+    }
+}
+
+static void G_DemoSeek (int tics)
+{
+    demoseektic = (demoseeking || demoseekpending ? demoseektic : defdemotics) + tics;
+    demoseektic = BETWEEN(0, deftotaldemotics - 1, demoseektic);
+    demoseekpending = true;
+}
+
+static boolean G_DemoSeekResponder (event_t* ev)
+{
+    if (ev->type != ev_keydown || !G_CanSeekDemo())
+    {
+	return false;
+    }
+
+    if (key_demoseekback && ev->data1 == key_demoseekback)
+    {
+	G_DemoSeek(-SEEKSTEP);
+	return true;
+    }
+
+    if (key_demoseekforward && ev->data1 == key_demoseekforward)
+    {
+	G_DemoSeek(SEEKSTEP);
+	return true;
+    }
+
+    return false;
+}
+
+static void G_ClearDemoSnapshots (void)
+{
+    int i;
+
+    for (i = 0; i < numdemosnapshots; i++)
+    {
+	P_FreeSnapshot(demosnapshots[i].snapshot);
+    }
+
+    numdemosnapshots = 0;
+    demoseekpending = false;
+    G_StopDemoSeek();
+}
+
+static void G_TakeDemoSnapshot (void)
+{
+    demosnapshot_t *ds;
+    snapshot_t *snapshot;
+
+    if ((snapshot = P_TakeSnapshot()) == NULL)
+    {
+	return;
+    }
+
+    if (numdemosnapshots == maxdemosnapshots)
+    {
+	maxdemosnapshots = maxdemosnapshots ? 2 * maxdemosnapshots : 64;
+	demosnapshots = I_Realloc(demosnapshots, maxdemosnapshots * sizeof(*demosnapshots));
+    }
+
+    ds = &demosnapshots[numdemosnapshots++];
+    ds->tic = defdemotics;
+    ds->demopos = demo_p - demobuffer;
+    ds->starttic = gametic - demostarttic;
+    ds->paused = paused & 1;
+    ds->snapshot = snapshot;
+}
+
+static void G_RestoreDemoSnapshot (demosnapshot_t *ds)
+{
+    const int player = displayplayer;
+
+    if (!P_OpenSnapshot(ds->snapshot))
+    {
+	return;
+    }
+
+    savedleveltime = leveltime;
+
+    // load a base level
+    G_InitNew (gameskill, gameepisode, gamemap);
+
+    leveltime = savedleveltime;
+    savedleveltime = 0;
+
+    P_LoadSnapshot(ds->snapshot);
+
+    // G_InitNew() has reset the demo state
+    usergame = false;
+    demoplayback = true;
+    CheckCrispySingleplayer(!demorecording && !demoplayback && !netgame);
+
+    defdemotics = ds->tic;
+    demo_p = demobuffer + ds->demopos;
+    demostarttic = gametic - ds->starttic;
+
+    paused = ds->paused;
+    if (paused)
+	S_PauseSound();
+
+    if (displayplayer != player && playeringame[player])
+    {
+	displayplayer = player;
+	ST_Start();
+	HU_Start();
+    }
+
+    // no screen wipe
+    wipegamestate = gamestate;
+
+    if (setsizeneeded)
+	R_ExecuteSetViewSize ();
+
+    R_FillBackScreen ();
+}
+
+//
+// G_DemoSeekTicker
+// Called at the start of each game tic, before the ticcmds are read.
+//
+static void G_DemoSeekTicker (void)
+{
+    int i;
+
+    if (!G_CanSeekDemo())
+    {
+	return;
+    }
+
+    if (demoseeking && defdemotics >= demoseektic)
+    {
+	G_StopDemoSeek();
+    }
+
+    if (demoseekpending)
+    {
+	demoseekpending = false;
+
+	// seeking ends a demo pause, or nothing would move
+	if (paused & 2)
+	{
+	    paused &= ~2;
+	    if (!paused)
+		S_ResumeSound();
+	}
+
+	for (i = numdemosnapshots - 1; i >= 0; i--)
+	{
+	    if (demosnapshots[i].tic <= demoseektic)
+		break;
+	}
+
+	// jump unless playing on from here gets there sooner
+	if (i >= 0 &&
+	    (demoseektic < defdemotics || demosnapshots[i].tic > defdemotics))
+	{
+	    G_RestoreDemoSnapshot(&demosnapshots[i]);
+	}
+
+	if (defdemotics < demoseektic)
+	{
+	    if (!demoseeking)
+	    {
+		seeknodrawers = nodrawers;
+		seeksingletics = singletics;
+		demoseeking = true;
+	    }
+
+	    nodrawers = true;
+	    singletics = true;
+	}
+	else
+	{
+	    G_StopDemoSeek();
+	}
+    }
+
+    if (gamestate == GS_LEVEL &&
+        (numdemosnapshots == 0 ||
+         defdemotics >= demosnapshots[numdemosnapshots - 1].tic + SNAPSHOTINTERVAL))
+    {
+	G_TakeDemoSnapshot();
+    }
+}
  
 
 //
@@ -3077,6 +3323,8 @@ void G_DoPlayDemo (void)
     boolean olddemo = false;
     int lumplength; // [crispy]
 
+    G_ClearDemoSnapshots(); // [crispy] demo seeking
+
     // [crispy] in demo continue mode free the obsolete demo buffer
     // of size 'maxsize' previously allocated in G_RecordDemo()
     if (demorecording)
@@ -3396,6 +3644,12 @@ boolean G_CheckDemoStatus (void)
     ticcmd_t* cmd = last_cmd;
     last_cmd = NULL;
 
+    // [crispy] playsim profiler
+    if (timingdemo || demoplayback)
+    {
+        P_ProfileReport();
+    }
+
     if (timingdemo) 
     { 
         float fps;
@@ -3416,6 +3670,7 @@ boolean G_CheckDemoStatus (void)
     if (demoplayback) 
     { 
         W_ReleaseLumpName(defdemoname);
+        G_ClearDemoSnapshots(); // [crispy] demo seeking
 	demoplayback = false; 
 	netdemo = false;
 	netgame = false;
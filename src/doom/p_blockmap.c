@@ -155,6 +155,7 @@ void P_CreateBlockMap(void)
 
       // Allocate blockmap lump with computed count
       blockmaplump = Z_Malloc(sizeof(*blockmaplump) * count, PU_LEVEL, 0);
+      blockmaplumpsize = count;
     }
 
     // Now compress the blockmap.
@@ -187,6 +188,9 @@ void P_CreateBlockMap(void)
     int count = sizeof(*blocklinks) * bmapwidth * bmapheight;
     blocklinks = Z_Malloc(count, PU_LEVEL, 0);
     memset(blocklinks, 0, count);
+    count = sizeof(*blockcells) * bmapwidth * bmapheight;
+    blockcells = Z_Malloc(count, PU_LEVEL, 0);
+    memset(blockcells, 0, count);
     blockmap = blockmaplump+4;
   }
 
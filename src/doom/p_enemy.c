@@ -571,7 +571,6 @@ P_LookForPlayers
 //
 void A_KeenDie (mobj_t* mo)
 {
-    thinker_t*	th;
     mobj_t*	mo2;
     line_t	junk;
 
@@ -579,14 +578,10 @@ void A_KeenDie (mobj_t* mo)
     
     // scan the remaining thinkers
     // to see if all Keens are dead
-    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+    // [crispy] only look at mobjs of the same type
+    for (mo2 = mobjtypehead[mo->type] ; mo2 ; mo2 = mo2->tnext)
     {
-	if (th->function.acp1 != (actionf_p1)P_MobjThinker)
-	    continue;
-
-	mo2 = (mobj_t *)th;
 	if (mo2 != mo
-	    && mo2->type == mo->type
 	    && mo2->health > 0)
 	{
 	    // other Keen not dead
@@ -1040,6 +1035,7 @@ void A_SkelMissile (mobj_t* actor)
 
     mo->x += mo->momx;
     mo->y += mo->momy;
+    P_UpdateBlockThing(mo); // [crispy] not relinked
     mo->tracer = actor->target;
 }
 
@@ -1391,6 +1387,7 @@ void A_VileAttack (mobj_t* actor)
     // move the fire between the vile and the player
     fire->x = actor->target->x - FixedMul (24*FRACUNIT, finecosine[an]);
     fire->y = actor->target->y - FixedMul (24*FRACUNIT, finesine[an]);	
+    P_UpdateBlockThing(fire); // [crispy] not relinked
     P_RadiusAttack (fire, actor, 70 );
 }
 
@@ -1524,19 +1521,10 @@ A_PainShootSkull
     angle_t	an;
     int		prestep;
     int		count;
-    thinker_t*	currentthinker;
 
     // count total number of skull currently on the level
-    count = 0;
-
-    currentthinker = thinkercap.next;
-    while (currentthinker != &thinkercap)
-    {
-	if (   (currentthinker->function.acp1 == (actionf_p1)P_MobjThinker)
-	    && ((mobj_t *)currentthinker)->type == MT_SKULL)
-	    count++;
-	currentthinker = currentthinker->next;
-    }
+    // [crispy] kept up to date as skulls are spawned and removed
+    count = mobjtypecount[MT_SKULL];
 
     // if there are allready 20 skulls on the level,
     // don't spit another one
@@ -1733,7 +1721,6 @@ static boolean CheckBossEnd(mobjtype_t motype)
 //
 void A_BossDeath (mobj_t* mo)
 {
-    thinker_t*	th;
     mobj_t*	mo2;
     line_t	junk;
     int		i;
@@ -1767,14 +1754,10 @@ void A_BossDeath (mobj_t* mo)
     
     // scan the remaining thinkers to see
     // if all bosses are dead
-    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+    // [crispy] only look at mobjs of the same type
+    for (mo2 = mobjtypehead[mo->type] ; mo2 ; mo2 = mo2->tnext)
     {
-	if (th->function.acp1 != (actionf_p1)P_MobjThinker)
-	    continue;
-	
-	mo2 = (mobj_t *)th;
 	if (mo2 != mo
-	    && mo2->type == mo->type
 	    && mo2->health > 0)
 	{
 	    // other boss not dead
@@ -1897,40 +1880,31 @@ mobj_t**		braintargets = NULL;
 int		numbraintargets = 0; // [crispy] initialize
 int		braintargeton = 0;
 static int	maxbraintargets; // [crispy] remove braintargets limit
+int		brainspiteasy = 0; // [crispy] moved out of A_BrainSpit() for snapshots
 
 void A_BrainAwake (mobj_t* mo)
 {
-    thinker_t*	thinker;
     mobj_t*	m;
 	
     // find all the target spots
     numbraintargets = 0;
     braintargeton = 0;
 
-    for (thinker = thinkercap.next ;
-	 thinker != &thinkercap ;
-	 thinker = thinker->next)
+    // [crispy] only look at boss targets, not every thinker
+    for (m = mobjtypehead[MT_BOSSTARGET] ; m ; m = m->tnext)
     {
-	if (thinker->function.acp1 != (actionf_p1)P_MobjThinker)
-	    continue;	// not a mobj
-
-	m = (mobj_t *)thinker;
-
-	if (m->type == MT_BOSSTARGET )
+	// [crispy] remove braintargets limit
+	if (numbraintargets == maxbraintargets)
 	{
-	    // [crispy] remove braintargets limit
-	    if (numbraintargets == maxbraintargets)
-	    {
-		maxbraintargets = maxbraintargets ? 2 * maxbraintargets : 32;
-		braintargets = I_Realloc(braintargets, maxbraintargets * sizeof(*braintargets));
+	    maxbraintargets = maxbraintargets ? 2 * maxbraintargets : 32;
+	    braintargets = I_Realloc(braintargets, maxbraintargets * sizeof(*braintargets));
 
-		if (maxbraintargets > 32)
-		    fprintf(stderr, "R_BrainAwake: Raised braintargets limit to %d.\n", maxbraintargets);
-	    }
-
-	    braintargets[numbraintargets] = m;
-	    numbraintargets++;
+	    if (maxbraintargets > 32)
+		fprintf(stderr, "R_BrainAwake: Raised braintargets limit to %d.\n", maxbraintargets);
 	}
+
+	braintargets[numbraintargets] = m;
+	numbraintargets++;
     }
 	
     S_StartSound (NULL,sfx_bossit);
@@ -2015,10 +1989,8 @@ void A_BrainSpit (mobj_t*	mo)
     mobj_t*	targ;
     mobj_t*	newmobj;
     
-    static int	easy = 0;
-	
-    easy ^= 1;
-    if (gameskill <= sk_easy && (!easy))
+    brainspiteasy ^= 1;
+    if (gameskill <= sk_easy && (!brainspiteasy))
 	return;
 		
     // [crispy] avoid division by zero by recalculating the number of spawn spots
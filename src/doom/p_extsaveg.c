@@ -115,10 +115,6 @@ static void P_ReadTotalLevelTimes (const char *key)
 	}
 }
 
-// T_FireFlicker()
-
-extern void T_FireFlicker (fireflicker_t* flick);
-
 static void P_WriteFireFlicker (const char *key)
 {
 	thinker_t* th;
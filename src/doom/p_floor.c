@@ -57,6 +57,9 @@ T_MovePlane
     sector->oldceilingheight = sector->ceilingheight;
     sector->oldgametic = gametic;
 
+    // [crispy] sight through this sector may change
+    P_ClearSightCache();
+
     switch(floorOrCeiling)
     {
       case 0:
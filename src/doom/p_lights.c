@@ -20,6 +20,8 @@
 
 
 #include "z_zone.h"
+#include "i_parallel.h"
+#include "i_system.h"
 #include "m_random.h"
 
 #include "doomdef.h"
@@ -37,14 +39,12 @@
 //
 // T_FireFlicker
 //
-void T_FireFlicker (fireflicker_t* flick)
+// [crispy] the random number is passed in, see P_RunLightThinkers()
+static void P_FireFlickerChange (fireflicker_t* flick, int rnd)
 {
     int	amount;
 	
-    if (--flick->count)
-	return;
-	
-    amount = (P_Random()&3)*16;
+    amount = (rnd&3)*16;
     
     if (flick->sector->lightlevel - amount < flick->minlight)
 	flick->sector->lightlevel = flick->minlight;
@@ -58,6 +58,14 @@ void T_FireFlicker (fireflicker_t* flick)
 	flick->sector->rlightlevel = flick->sector->lightlevel;
 }
 
+void T_FireFlicker (fireflicker_t* flick)
+{
+    if (--flick->count)
+	return;
+	
+    P_FireFlickerChange (flick, P_Random());
+}
+
 
 
 //
@@ -93,20 +101,18 @@ void P_SpawnFireFlicker (sector_t*	sector)
 // T_LightFlash
 // Do flashing lights.
 //
-void T_LightFlash (lightflash_t* flash)
+// [crispy] the random number is passed in, see P_RunLightThinkers()
+static void P_LightFlashChange (lightflash_t* flash, int rnd)
 {
-    if (--flash->count)
-	return;
-	
     if (flash->sector->lightlevel == flash->maxlight)
     {
 	flash-> sector->lightlevel = flash->minlight;
-	flash->count = (P_Random()&flash->mintime)+1;
+	flash->count = (rnd&flash->mintime)+1;
     }
     else
     {
 	flash-> sector->lightlevel = flash->maxlight;
-	flash->count = (P_Random()&flash->maxtime)+1;
+	flash->count = (rnd&flash->maxtime)+1;
     }
 
     // [crispy] A11Y
@@ -114,6 +120,14 @@ void T_LightFlash (lightflash_t* flash)
 	flash->sector->rlightlevel = flash->sector->lightlevel;
 }
 
+void T_LightFlash (lightflash_t* flash)
+{
+    if (--flash->count)
+	return;
+	
+    P_LightFlashChange (flash, P_Random());
+}
+
 
 
 
@@ -367,3 +381,132 @@ void P_SpawnGlowingLight(sector_t*	sector)
     sector->special = 0;
 }
 
+
+
+//
+// [crispy] PARALLEL LIGHT THINKERS
+//
+// Light thinkers only change their own sector's light level, so a run
+// of them next to each other in the thinker list can be processed in
+// any order as long as no two of them share a sector.  The random
+// numbers that flickering and flashing lights use are drawn up front
+// in thinker order, so the random number sequence stays the same.
+//
+
+// Runs shorter than this are not worth handing to other threads.
+#define MINPARALLELLIGHTS	512
+
+typedef struct
+{
+    thinker_t*	thinker;
+    int		rnd;
+} lightjob_t;
+
+static lightjob_t*	lightjobs;
+static int		maxlightjobs;
+
+static sector_t* P_LightThinkerSector (thinker_t* th)
+{
+    if (th->function.acp1 == (actionf_p1) T_FireFlicker)
+	return ((fireflicker_t *) th)->sector;
+    if (th->function.acp1 == (actionf_p1) T_LightFlash)
+	return ((lightflash_t *) th)->sector;
+    if (th->function.acp1 == (actionf_p1) T_StrobeFlash)
+	return ((strobe_t *) th)->sector;
+    if (th->function.acp1 == (actionf_p1) T_Glow)
+	return ((glow_t *) th)->sector;
+
+    return NULL;
+}
+
+boolean P_IsLightThinker (thinker_t* th)
+{
+    return P_LightThinkerSector(th) != NULL;
+}
+
+static void P_RunLightJobs (void* data, int start, int end)
+{
+    lightjob_t*	job;
+    thinker_t*	th;
+
+    for (job = &lightjobs[start]; job < &lightjobs[end]; job++)
+    {
+	th = job->thinker;
+
+	if (th->function.acp1 == (actionf_p1) T_FireFlicker)
+	{
+	    if (!--((fireflicker_t *) th)->count)
+		P_FireFlickerChange((fireflicker_t *) th, job->rnd);
+	}
+	else if (th->function.acp1 == (actionf_p1) T_LightFlash)
+	{
+	    if (!--((lightflash_t *) th)->count)
+		P_LightFlashChange((lightflash_t *) th, job->rnd);
+	}
+	else
+	{
+	    th->function.acp1(th);
+	}
+    }
+}
+
+//
+// P_RunLightThinkers
+// Runs the light thinkers starting at the given one, up to the first
+// thinker that is not a light or shares a sector with an earlier one.
+// Returns that thinker.
+//
+thinker_t* P_RunLightThinkers (thinker_t* first)
+{
+    thinker_t*	th;
+    sector_t*	sec;
+    int		numjobs;
+    int		i;
+
+    numjobs = 0;
+    validcount++;
+
+    for (th = first; th != &thinkercap; th = th->next)
+    {
+	sec = P_LightThinkerSector(th);
+
+	if (sec == NULL || sec->validcount == validcount)
+	    break;
+
+	sec->validcount = validcount;
+
+	if (numjobs == maxlightjobs)
+	{
+	    maxlightjobs = maxlightjobs ? 2 * maxlightjobs : 1024;
+	    lightjobs = I_Realloc(lightjobs, maxlightjobs * sizeof(*lightjobs));
+	}
+
+	lightjobs[numjobs++].thinker = th;
+    }
+
+    if (numjobs < MINPARALLELLIGHTS)
+    {
+	for (i = 0; i < numjobs; i++)
+	    lightjobs[i].thinker->function.acp1(lightjobs[i].thinker);
+
+	return th;
+    }
+
+    // draw the random numbers in the order the thinkers would
+    for (i = 0; i < numjobs; i++)
+    {
+	thinker_t* job = lightjobs[i].thinker;
+
+	if ((job->function.acp1 == (actionf_p1) T_FireFlicker
+	     && ((fireflicker_t *) job)->count == 1)
+	 || (job->function.acp1 == (actionf_p1) T_LightFlash
+	     && ((lightflash_t *) job)->count == 1))
+	{
+	    lightjobs[i].rnd = P_Random();
+	}
+    }
+
+    I_ParallelFor(P_RunLightJobs, NULL, numjobs);
+
+    return th;
+}
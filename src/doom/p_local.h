@@ -115,6 +115,13 @@ P_SpawnMobj
   mobjtype_t	type );
 
 void 	P_RemoveMobj (mobj_t* th);
+
+// [crispy] lists of the mobjs of each type, in thinker list order
+extern mobj_t*	mobjtypehead[NUMMOBJTYPES];
+extern int	mobjtypecount[NUMMOBJTYPES];
+void	P_ClearMobjTypeLists (void);
+void	P_LinkMobjType (mobj_t* mobj);
+
 mobj_t* P_SubstNullMobj (mobj_t* th);
 boolean	P_SetMobjState (mobj_t* mobj, statenum_t state);
 void 	P_MobjThinker (mobj_t* mobj);
@@ -179,8 +186,46 @@ extern fixed_t		lowfloor;
 
 void 	P_LineOpening (line_t* linedef);
 
+// [crispy] the geometry of the lines in a blockmap cell, see P_InitBlockLines()
+typedef struct
+{
+    line_t*	line;
+    fixed_t	bbox[4];
+    fixed_t	x1;
+    fixed_t	y1;
+    fixed_t	x2;
+    fixed_t	y2;
+    fixed_t	dx;
+    fixed_t	dy;
+} blockline_t;
+
 boolean P_BlockLinesIterator (int x, int y, boolean(*func)(line_t*) );
+boolean P_BlockLinesIteratorNear (int x, int y,
+                                  boolean(*far)(const blockline_t*),
+                                  boolean(*func)(line_t*) ); // [crispy]
+void P_InitBlockLines (void); // [crispy]
+
+// [crispy] compact copies of the blocklinks chains, see P_SetThingPosition()
+typedef struct
+{
+    mobj_t*	mo;
+    fixed_t	x;
+    fixed_t	y;
+    fixed_t	radius;
+} blockthing_t;
+
+typedef struct
+{
+    blockthing_t*	things;		// oldest first, i.e. in reverse link order
+    int			numthings;
+    int			maxthings;
+    boolean		diverged;	// links changed behind our back, walk them
+} blockcell_t;
+
 boolean P_BlockThingsIterator (int x, int y, boolean(*func)(mobj_t*) );
+boolean P_BlockThingsIteratorNear (int x, int y,
+                                   boolean(*far)(const blockthing_t*),
+                                   boolean(*func)(mobj_t*) ); // [crispy]
 
 #define PT_ADDLINES		1
 #define PT_ADDTHINGS	2
@@ -199,6 +244,12 @@ P_PathTraverse
 
 void P_UnsetThingPosition (mobj_t* thing);
 void P_SetThingPosition (mobj_t* thing);
+void P_UpdateBlockThing (mobj_t* thing); // [crispy]
+void P_RebuildBlockThings (void); // [crispy]
+
+// [crispy] lists of the mobjs touching each sector
+extern boolean	sectorthinglists;
+void P_InitSecnodes (void);
 
 
 //
@@ -233,6 +284,8 @@ boolean P_TryMove (mobj_t* thing, fixed_t x, fixed_t y);
 boolean P_TeleportMove (mobj_t* thing, fixed_t x, fixed_t y);
 void	P_SlideMove (mobj_t* mo);
 boolean P_CheckSight (mobj_t* t1, mobj_t* t2);
+void	P_InitSightCache (void); // [crispy]
+void	P_ClearSightCache (void); // [crispy]
 void 	P_UseLines (player_t* player);
 
 boolean P_ChangeSector (sector_t* sector, boolean crunch);
@@ -274,12 +327,21 @@ P_RadiusAttack
 //
 extern byte*		rejectmatrix;	// for fast sight rejection
 extern int32_t*	blockmaplump;	// offsets in blockmap are from here // [crispy] BLOCKMAP limit
+extern int		blockmaplumpsize; // [crispy] entries in blockmaplump[]
 extern int32_t*	blockmap; // [crispy] BLOCKMAP limit
 extern int		bmapwidth;
 extern int		bmapheight;	// in mapblocks
 extern fixed_t		bmaporgx;
 extern fixed_t		bmaporgy;	// origin of block map
 extern mobj_t**		blocklinks;	// for thing chains
+extern blockcell_t*	blockcells;	// [crispy] the same as arrays
+
+// [crispy] the line lists of all cells, one after the other
+extern blockline_t*	blocklines;
+extern int*		blocklineoffsets;
+
+// [crispy] if == validcount, already checked
+extern int*		linevalidcount;
 
 // [crispy] factor out map lump name and number finding into a separate function
 extern int P_GetNumForMap (int episode, int map, boolean critical);
@@ -92,6 +92,19 @@ static int spechit_max; // [crispy] remove SPECHIT limit
 // TELEPORT MOVE
 // 
 
+//
+// PIT_FarFromTmThing
+// [crispy] Things PIT_StompThing() and PIT_CheckThing() do not reach.
+//
+static boolean PIT_FarFromTmThing (const blockthing_t* bt)
+{
+    const fixed_t	blockdist = bt->radius + tmthing->radius;
+
+    return abs(bt->x - tmx) >= blockdist
+        || abs(bt->y - tmy) >= blockdist;
+}
+
+
 //
 // PIT_StompThing
 //
@@ -176,7 +189,7 @@ P_TeleportMove
 
     for (bx=xl ; bx<=xh ; bx++)
 	for (by=yl ; by<=yh ; by++)
-	    if (!P_BlockThingsIterator(bx,by,PIT_StompThing))
+	    if (!P_BlockThingsIteratorNear(bx,by,PIT_FarFromTmThing,PIT_StompThing))
 		return false;
     
     // the move is ok,
@@ -204,6 +217,19 @@ P_TeleportMove
 
 static void SpechitOverrun(line_t *ld);
 
+//
+// PIT_FarFromTmBox
+// [crispy] Lines outside the bounding box PIT_CheckLine() checks.
+//
+static boolean PIT_FarFromTmBox (const blockline_t* bl)
+{
+    return tmbbox[BOXRIGHT] <= bl->bbox[BOXLEFT]
+        || tmbbox[BOXLEFT] >= bl->bbox[BOXRIGHT]
+        || tmbbox[BOXTOP] <= bl->bbox[BOXBOTTOM]
+        || tmbbox[BOXBOTTOM] >= bl->bbox[BOXTOP];
+}
+
+
 //
 // PIT_CheckLine
 // Adjusts tmfloorz and tmceilingz as lines are contacted
@@ -537,7 +563,7 @@ P_CheckPosition
 
     for (bx=xl ; bx<=xh ; bx++)
 	for (by=yl ; by<=yh ; by++)
-	    if (!P_BlockThingsIterator(bx,by,PIT_CheckThing))
+	    if (!P_BlockThingsIteratorNear(bx,by,PIT_FarFromTmThing,PIT_CheckThing))
 		return false;
     
     // check lines
@@ -548,7 +574,7 @@ P_CheckPosition
 
     for (bx=xl ; bx<=xh ; bx++)
 	for (by=yl ; by<=yh ; by++)
-	    if (!P_BlockLinesIterator (bx,by,PIT_CheckLine))
+	    if (!P_BlockLinesIteratorNear (bx,by,PIT_FarFromTmBox,PIT_CheckLine))
 		return false;
 
     return true;
@@ -1411,6 +1437,28 @@ mobj_t*		bombspot;
 int		bombdamage;
 
 
+//
+// PIT_FarFromBombSpot
+// [crispy] Things out of range for PIT_RadiusAttack().
+//
+static boolean PIT_FarFromBombSpot (const blockthing_t* bt)
+{
+    fixed_t	dx;
+    fixed_t	dy;
+    fixed_t	dist;
+
+    dx = abs(bt->x - bombspot->x);
+    dy = abs(bt->y - bombspot->y);
+
+    dist = dx>dy ? dx : dy;
+    dist = (dist - bt->radius) >> FRACBITS;
+
+    if (dist < 0)
+	dist = 0;
+
+    return dist >= bombdamage;
+}
+
 //
 // PIT_RadiusAttack
 // "bombsource" is the creature
@@ -1484,7 +1532,7 @@ P_RadiusAttack
 	
     for (y=yl ; y<=yh ; y++)
 	for (x=xl ; x<=xh ; x++)
-	    P_BlockThingsIterator (x, y, PIT_RadiusAttack );
+	    P_BlockThingsIteratorNear (x, y, PIT_FarFromBombSpot, PIT_RadiusAttack );
 }
 
 
@@ -1533,6 +1581,7 @@ boolean PIT_ChangeSector (mobj_t*	thing)
 	    thing->flags &= ~MF_SOLID;
 	thing->height = 0;
 	thing->radius = 0;
+	P_UpdateBlockThing(thing); // [crispy] not relinked
 
 	// [crispy] connect giblet object with the crushed monster
 	thing->target = thing;
@@ -1595,9 +1644,46 @@ P_ChangeSector
 {
     int		x;
     int		y;
+    int		i;
+    int		numthings;
+    msecnode_t*	node;
+    static mobj_t**	things;
+    static int	maxthings;
 	
     nofit = false;
     crushchange = crunch;
+
+    // [crispy] only re-check the things touching the moving sector.
+    // Demos and net games keep the vanilla order, and also re-check
+    // things near the sector that do not touch it.
+    if (sectorthinglists && crispy->singleplayer)
+    {
+	// PIT_ChangeSector spawns and removes things, which changes
+	// the list, so go through a copy of it
+	numthings = 0;
+
+	for (node = sector->touching_thinglist; node; node = node->m_snext)
+	{
+	    if (numthings == maxthings)
+	    {
+		maxthings = maxthings ? 2 * maxthings : 64;
+		things = I_Realloc(things, maxthings * sizeof(*things));
+	    }
+
+	    things[numthings++] = node->m_thing;
+	}
+
+	for (i = 0; i < numthings; i++)
+	{
+	    // removed by an earlier one?
+	    if (things[i]->thinker.function.acv == (actionf_v)(-1))
+		continue;
+
+	    PIT_ChangeSector(things[i]);
+	}
+
+	return nofit;
+    }
 	
     // re-check heights for all things near the moving sector
     for (x=sector->blockbox[BOXLEFT] ; x<= sector->blockbox[BOXRIGHT] ; x++)
@@ -23,6 +23,7 @@
 
 
 #include <stdlib.h>
+#include <string.h> // [crispy] memcpy(), memmove()
 
 
 #include "i_system.h" // [crispy] I_Realloc()
@@ -31,6 +32,7 @@
 #include "doomdef.h"
 #include "doomstat.h"
 #include "p_local.h"
+#include "z_zone.h"
 
 
 // State.
@@ -60,43 +62,56 @@ P_AproxDistance
 // P_PointOnLineSide
 // Returns 0 or 1
 //
-int
-P_PointOnLineSide
+// [crispy] split off for lines in blockline_t, which have no line_t
+static int
+PointOnLineSide
 ( fixed_t	x,
   fixed_t	y,
-  line_t*	line )
+  fixed_t	linex,
+  fixed_t	liney,
+  fixed_t	linedx,
+  fixed_t	linedy )
 {
     fixed_t	dx;
     fixed_t	dy;
     fixed_t	left;
     fixed_t	right;
 	
-    if (!line->dx)
+    if (!linedx)
     {
-	if (x <= line->v1->x)
-	    return line->dy > 0;
+	if (x <= linex)
+	    return linedy > 0;
 	
-	return line->dy < 0;
+	return linedy < 0;
     }
-    if (!line->dy)
+    if (!linedy)
     {
-	if (y <= line->v1->y)
-	    return line->dx < 0;
+	if (y <= liney)
+	    return linedx < 0;
 	
-	return line->dx > 0;
+	return linedx > 0;
     }
 	
-    dx = (x - line->v1->x);
-    dy = (y - line->v1->y);
+    dx = (x - linex);
+    dy = (y - liney);
 	
-    left = FixedMul ( line->dy>>FRACBITS , dx );
-    right = FixedMul ( dy , line->dx>>FRACBITS );
+    left = FixedMul ( linedy>>FRACBITS , dx );
+    right = FixedMul ( dy , linedx>>FRACBITS );
 	
     if (right < left)
 	return 0;		// front side
     return 1;			// back side
 }
 
+int
+P_PointOnLineSide
+( fixed_t	x,
+  fixed_t	y,
+  line_t*	line )
+{
+    return PointOnLineSide(x, y, line->v1->x, line->v1->y, line->dx, line->dy);
+}
+
 
 
 //
@@ -342,10 +357,324 @@ void P_LineOpening (line_t* linedef)
 // lookups maintaining lists ot things inside
 // these structures need to be updated.
 //
+//
+// [crispy] SECTOR TOUCHING LISTS
+//
+// Every mobj in the blockmap is linked to the sectors its bounding box
+// touches, so that P_ChangeSector only has to look at the mobjs in
+// contact with a moving sector.  The links are made and broken along
+// with the blockmap links.
+//
+
+boolean		sectorthinglists;
+static msecnode_t*	freesecnodes;
+
+//
+// P_InitSecnodes
+// Called at level load, after the level zone has been freed.
+//
+void P_InitSecnodes (void)
+{
+    freesecnodes = NULL;
+
+    // Demos and net games keep the vanilla P_ChangeSector, so do not
+    // bother with the lists there. G_DoPlayDemo() only sets demoplayback
+    // after the level has been set up, so P_SetThingPosition() checks
+    // again and gives up on the lists for the rest of the level.
+    sectorthinglists = crispy->singleplayer;
+}
+
+static void P_AddSecnode (sector_t* sec, mobj_t* thing)
+{
+    msecnode_t*	node;
+
+    // already touching?
+    for (node = thing->touching_sectorlist; node; node = node->m_tnext)
+    {
+	if (node->m_sector == sec)
+	    return;
+    }
+
+    if (freesecnodes)
+    {
+	node = freesecnodes;
+	freesecnodes = node->m_tnext;
+    }
+    else
+    {
+	node = Z_Malloc(sizeof(*node), PU_LEVEL, NULL);
+    }
+
+    node->m_sector = sec;
+    node->m_thing = thing;
+
+    node->m_tnext = thing->touching_sectorlist;
+    thing->touching_sectorlist = node;
+
+    node->m_sprev = NULL;
+    node->m_snext = sec->touching_thinglist;
+    if (sec->touching_thinglist)
+	sec->touching_thinglist->m_sprev = node;
+    sec->touching_thinglist = node;
+}
+
+static void P_DelSecnodes (mobj_t* thing)
+{
+    msecnode_t*	node;
+    msecnode_t*	next;
+
+    for (node = thing->touching_sectorlist; node; node = next)
+    {
+	next = node->m_tnext;
+
+	if (node->m_snext)
+	    node->m_snext->m_sprev = node->m_sprev;
+
+	if (node->m_sprev)
+	    node->m_sprev->m_snext = node->m_snext;
+	else
+	    node->m_sector->touching_thinglist = node->m_snext;
+
+	node->m_tnext = freesecnodes;
+	freesecnodes = node;
+    }
+
+    thing->touching_sectorlist = NULL;
+}
+
+//
+// P_SetSecnodes
+// Links the thing to its own sector and the sectors on both sides
+// of every line its bounding box crosses.
+//
+static void P_SetSecnodes (mobj_t* thing)
+{
+    fixed_t	bbox[4];
+    int		xl;
+    int		xh;
+    int		yl;
+    int		yh;
+    int		bx;
+    int		by;
+    int32_t*	list;
+    line_t*	ld;
+
+    thing->touching_sectorlist = NULL;
+    P_AddSecnode(thing->subsector->sector, thing);
+
+    bbox[BOXTOP] = thing->y + thing->radius;
+    bbox[BOXBOTTOM] = thing->y - thing->radius;
+    bbox[BOXRIGHT] = thing->x + thing->radius;
+    bbox[BOXLEFT] = thing->x - thing->radius;
+
+    xl = (bbox[BOXLEFT] - bmaporgx)>>MAPBLOCKSHIFT;
+    xh = (bbox[BOXRIGHT] - bmaporgx)>>MAPBLOCKSHIFT;
+    yl = (bbox[BOXBOTTOM] - bmaporgy)>>MAPBLOCKSHIFT;
+    yh = (bbox[BOXTOP] - bmaporgy)>>MAPBLOCKSHIFT;
+
+    if (xl < 0)
+	xl = 0;
+    if (yl < 0)
+	yl = 0;
+    if (xh >= bmapwidth)
+	xh = bmapwidth - 1;
+    if (yh >= bmapheight)
+	yh = bmapheight - 1;
+
+    // Lines in more than one block are checked more than once, but
+    // that is cheaper than using validcount here, as things are
+    // positioned from within the other iterators.
+    for (bx = xl; bx <= xh; bx++)
+    {
+	for (by = yl; by <= yh; by++)
+	{
+	    for (list = blockmaplump + blockmap[by*bmapwidth+bx];
+	         *list != -1; list++)
+	    {
+		ld = &lines[*list];
+
+		if (bbox[BOXRIGHT] <= ld->bbox[BOXLEFT]
+		 || bbox[BOXLEFT] >= ld->bbox[BOXRIGHT]
+		 || bbox[BOXTOP] <= ld->bbox[BOXBOTTOM]
+		 || bbox[BOXBOTTOM] >= ld->bbox[BOXTOP])
+		    continue;
+
+		if (P_BoxOnLineSide(bbox, ld) != -1)
+		    continue;
+
+		P_AddSecnode(ld->frontsector, thing);
+
+		if (ld->backsector)
+		    P_AddSecnode(ld->backsector, thing);
+	    }
+	}
+    }
+}
+
+
+//
+// [crispy] BLOCKCELLS
+// Every blocklinks chain is mirrored by an array of the things in it and
+// their position, so the block things iterators can run through contiguous
+// memory and skip things out of reach without touching them.
+//
+// Demos depend on the chains, though, including the way
+// P_UnsetThingPosition() cuts them up when a thing has been moved without
+// relinking it. Whenever the links change in a way the arrays do not
+// follow, the cells involved are marked as diverged and the iterators walk
+// their links again.
+//
+
+// counts link changes, to notice when an iterator callback moved things
+static unsigned int blocklinkchanges;
+
+static void P_DivergeBlockCell (int cell)
+{
+    if (cell >= 0)
+	blockcells[cell].diverged = true;
+}
+
+// the cell's array, if it is still in step with the chain
+static blockcell_t *P_SyncedBlockCell (int cell)
+{
+    if (cell < 0 || blockcells[cell].diverged)
+	return NULL;
+
+    return &blockcells[cell];
+}
+
+static void P_ReserveBlockThings (blockcell_t* bc, int numthings)
+{
+    blockthing_t*	things;
+
+    if (numthings <= bc->maxthings)
+	return;
+
+    while (bc->maxthings < numthings)
+	bc->maxthings = bc->maxthings ? 2 * bc->maxthings : 8;
+
+    things = Z_Malloc(bc->maxthings * sizeof(*things), PU_LEVEL, 0);
+
+    if (bc->things)
+    {
+	memcpy(things, bc->things, bc->numthings * sizeof(*things));
+	Z_Free(bc->things);
+    }
+
+    bc->things = things;
+}
+
+static void P_SetBlockThing (blockthing_t* bt, mobj_t* thing)
+{
+    bt->mo = thing;
+    bt->x = thing->x;
+    bt->y = thing->y;
+    bt->radius = thing->radius;
+}
+
+static blockthing_t *P_FindBlockThing (blockcell_t* bc, mobj_t* thing)
+{
+    int		i;
+
+    // things that were linked last are at the end
+    for (i = bc->numthings - 1; i >= 0; i--)
+    {
+	if (bc->things[i].mo == thing)
+	    return &bc->things[i];
+    }
+
+    return NULL;
+}
+
+static void P_RemoveBlockThing (blockcell_t* bc, mobj_t* thing)
+{
+    blockthing_t*	bt = P_FindBlockThing(bc, thing);
+
+    if (!bt)
+    {
+	bc->diverged = true;
+	return;
+    }
+
+    bc->numthings--;
+    memmove(bt, bt + 1, (bc->things + bc->numthings - bt) * sizeof(*bt));
+}
+
+//
+// P_UpdateBlockThing
+// Call after changing a thing's x, y or radius without relinking it.
+//
+void P_UpdateBlockThing (mobj_t* thing)
+{
+    blockcell_t*	bc;
+    blockthing_t*	bt;
+
+    if ((bc = P_SyncedBlockCell(thing->blockcell))
+     && (bt = P_FindBlockThing(bc, thing)))
+    {
+	P_SetBlockThing(bt, thing);
+    }
+}
+
+//
+// P_RebuildBlockThings
+// Call after setting the blocklinks chains directly.
+//
+void P_RebuildBlockThings (void)
+{
+    thinker_t*		th;
+    mobj_t*		mobj;
+    mobj_t*		prev;
+    blockcell_t*	bc;
+    int			cell;
+    int			i;
+
+    for (th = thinkercap.next; th != &thinkercap; th = th->next)
+    {
+	if (th->function.acp1 == (actionf_p1) P_MobjThinker)
+	    ((mobj_t *) th)->blockcell = -1;
+    }
+
+    for (cell = 0; cell < bmapwidth * bmapheight; cell++)
+    {
+	bc = &blockcells[cell];
+	bc->numthings = 0;
+	bc->diverged = false;
+
+	for (prev = NULL, mobj = blocklinks[cell]; mobj;
+	     prev = mobj, mobj = mobj->bnext)
+	{
+	    // out of step, or shared with another chain
+	    if (mobj->bprev != prev || mobj->blockcell != -1)
+	    {
+		bc->diverged = true;
+		break;
+	    }
+
+	    mobj->blockcell = cell;
+	    bc->numthings++;
+	}
+
+	if (bc->diverged)
+	    continue;
+
+	P_ReserveBlockThings(bc, bc->numthings);
+
+	for (i = bc->numthings - 1, mobj = blocklinks[cell]; mobj;
+	     i--, mobj = mobj->bnext)
+	{
+	    P_SetBlockThing(&bc->things[i], mobj);
+	}
+    }
+}
+
+
 void P_UnsetThingPosition (mobj_t* thing)
 {
     int		blockx;
     int		blocky;
+    int		cell;
+    blockcell_t*	bc;
 
     if ( ! (thing->flags & MF_NOSECTOR) )
     {
@@ -364,11 +693,24 @@ void P_UnsetThingPosition (mobj_t* thing)
     {
 	// inert things don't need to be in blockmap
 	// unlink from block map
+	bc = P_SyncedBlockCell(thing->blockcell);
+
+	// [crispy] links into other chains leave those out of step
 	if (thing->bnext)
+	{
+	    if (thing->bnext->blockcell != thing->blockcell)
+		P_DivergeBlockCell(thing->bnext->blockcell);
+
 	    thing->bnext->bprev = thing->bprev;
+	}
 	
 	if (thing->bprev)
+	{
+	    if (thing->bprev->blockcell != thing->blockcell)
+		P_DivergeBlockCell(thing->bprev->blockcell);
+
 	    thing->bprev->bnext = thing->bnext;
+	}
 	else
 	{
 	    blockx = (thing->x - bmaporgx)>>MAPBLOCKSHIFT;
@@ -377,10 +719,34 @@ void P_UnsetThingPosition (mobj_t* thing)
 	    if (blockx>=0 && blockx < bmapwidth
 		&& blocky>=0 && blocky <bmapheight)
 	    {
-		blocklinks[blocky*bmapwidth+blockx] = thing->bnext;
+		cell = blocky*bmapwidth+blockx;
+		blocklinks[cell] = thing->bnext;
+
+		// [crispy] moved without relinking, so this cut off
+		// another chain and left the thing at the head of its own
+		if (cell != thing->blockcell)
+		{
+		    P_DivergeBlockCell(cell);
+		    P_DivergeBlockCell(thing->blockcell);
+		}
+	    }
+	    else
+	    {
+		P_DivergeBlockCell(thing->blockcell);
 	    }
 	}
+
+	// [crispy] unless one of the above took the cell out of step
+	if (bc && !bc->diverged)
+	    P_RemoveBlockThing(bc, thing);
+
+	thing->blockcell = -1;
+	blocklinkchanges++;
     }
+
+    // [crispy] unlink from the sectors it touches
+    if (thing->touching_sectorlist)
+	P_DelSecnodes(thing);
 }
 
 
@@ -397,7 +763,9 @@ P_SetThingPosition (mobj_t* thing)
     sector_t*		sec;
     int			blockx;
     int			blocky;
+    int			cell;
     mobj_t**		link;
+    blockcell_t*	bc;
 
     
     // link into subsector
@@ -426,24 +794,53 @@ P_SetThingPosition (mobj_t* thing)
 	blockx = (thing->x - bmaporgx)>>MAPBLOCKSHIFT;
 	blocky = (thing->y - bmaporgy)>>MAPBLOCKSHIFT;
 
+	// [crispy] if it is still linked, this changes the chain it is in
+	P_DivergeBlockCell(thing->blockcell);
+
 	if (blockx>=0
 	    && blockx < bmapwidth
 	    && blocky>=0
 	    && blocky < bmapheight)
 	{
-	    link = &blocklinks[blocky*bmapwidth+blockx];
+	    cell = blocky*bmapwidth+blockx;
+	    link = &blocklinks[cell];
 	    thing->bprev = NULL;
 	    thing->bnext = *link;
 	    if (*link)
+	    {
+		// [crispy] the old head is in another chain, too
+		if ((*link)->blockcell != cell)
+		    P_DivergeBlockCell((*link)->blockcell);
+
 		(*link)->bprev = thing;
+	    }
 
 	    *link = thing;
+
+	    // [crispy] append to the array, the head comes last there
+	    thing->blockcell = cell;
+
+	    if ((bc = P_SyncedBlockCell(cell)))
+	    {
+		P_ReserveBlockThings(bc, bc->numthings + 1);
+		P_SetBlockThing(&bc->things[bc->numthings++], thing);
+	    }
+
+	    // [crispy] link to the sectors it touches
+	    if (sectorthinglists && !crispy->singleplayer)
+		sectorthinglists = false;
+
+	    if (sectorthinglists)
+		P_SetSecnodes(thing);
 	}
 	else
 	{
 	    // thing is off the map
 	    thing->bnext = thing->bprev = NULL;
+	    thing->blockcell = -1; // [crispy]
 	}
+
+	blocklinkchanges++; // [crispy]
     }
 }
 
@@ -459,22 +856,100 @@ P_SetThingPosition (mobj_t* thing)
 
 
 //
-// P_BlockLinesIterator
+// P_InitBlockLines
+// [crispy] Copy what the block lines iterators look at first from the
+// lines into one array per cell, so they can reject most lines out of
+// contiguous memory. Called at level load, after the blockmap.
+//
+void P_InitBlockLines (void)
+{
+    int			numcells;
+    int			numblocklines;
+    int			cell;
+    int			i;
+    int32_t*		list;
+    blockline_t*	bl;
+    line_t*		ld;
+
+    linevalidcount = Z_Malloc(numlines * sizeof(*linevalidcount), PU_LEVEL, 0);
+    memset(linevalidcount, 0, numlines * sizeof(*linevalidcount));
+
+    blocklines = NULL;
+    numcells = bmapwidth * bmapheight;
+
+    // broken blockmaps keep going through blockmaplump[] as before
+    if (4 + numcells > blockmaplumpsize)
+	return;
+
+    blocklineoffsets = Z_Malloc((numcells + 1) * sizeof(*blocklineoffsets),
+                                PU_LEVEL, 0);
+    numblocklines = 0;
+
+    for (cell = 0; cell < numcells; cell++)
+    {
+	blocklineoffsets[cell] = numblocklines;
+
+	for (i = blockmap[cell]; ; i++)
+	{
+	    if (i < 0 || i >= blockmaplumpsize)
+		return;
+
+	    if (blockmaplump[i] == -1)
+		break;
+
+	    if (blockmaplump[i] < 0 || blockmaplump[i] >= numlines)
+		return;
+
+	    numblocklines++;
+	}
+    }
+
+    blocklineoffsets[numcells] = numblocklines;
+
+    blocklines = Z_Malloc(numblocklines * sizeof(*blocklines), PU_LEVEL, 0);
+
+    for (cell = 0, bl = blocklines; cell < numcells; cell++)
+    {
+	for (list = blockmaplump + blockmap[cell]; *list != -1; list++, bl++)
+	{
+	    ld = &lines[*list];
+
+	    bl->line = ld;
+	    memcpy(bl->bbox, ld->bbox, sizeof(bl->bbox));
+	    bl->x1 = ld->v1->x;
+	    bl->y1 = ld->v1->y;
+	    bl->x2 = ld->v2->x;
+	    bl->y2 = ld->v2->y;
+	    bl->dx = ld->dx;
+	    bl->dy = ld->dy;
+	}
+    }
+}
+
+
+//
+// P_BlockLinesIteratorNear
 // The validcount flags are used to avoid checking lines
 // that are marked in multiple mapblocks,
 // so increment validcount before the first call
 // to P_BlockLinesIterator, then make one or more calls
 // to it.
 //
+// [crispy] Skips the lines far() returns true for, which func() has to
+// reject itself without any side effects.
+//
 boolean
-P_BlockLinesIterator
+P_BlockLinesIteratorNear
 ( int			x,
   int			y,
+  boolean(*far)(const blockline_t*),
   boolean(*func)(line_t*) )
 {
     int			offset;
     int32_t*		list; // [crispy] BLOCKMAP limit
     line_t*		ld;
+    blockline_t*	bl;
+    blockline_t*	end;
 	
     if (x<0
 	|| y<0
@@ -486,16 +961,38 @@ P_BlockLinesIterator
     
     offset = y*bmapwidth+x;
 	
+    // [crispy]
+    if (blocklines)
+    {
+	bl = blocklines + blocklineoffsets[offset];
+	end = blocklines + blocklineoffsets[offset + 1];
+
+	for ( ; bl < end; bl++)
+	{
+	    if (linevalidcount[bl->line - lines] == validcount)
+		continue; 	// line has already been checked
+
+	    linevalidcount[bl->line - lines] = validcount;
+
+	    if (far && far(bl))
+		continue;
+
+	    if ( !func(bl->line) )
+		return false;
+	}
+	return true;
+    }
+
     offset = *(blockmap+offset);
 
     for ( list = blockmaplump+offset ; *list != -1 ; list++)
     {
 	ld = &lines[*list];
 
-	if (ld->validcount == validcount)
+	if (linevalidcount[*list] == validcount)
 	    continue; 	// line has already been checked
 
-	ld->validcount = validcount;
+	linevalidcount[*list] = validcount;
 		
 	if ( !func(ld) )
 	    return false;
@@ -503,17 +1000,37 @@ P_BlockLinesIterator
     return true;	// everything was checked
 }
 
+//
+// P_BlockLinesIterator
+//
+boolean
+P_BlockLinesIterator
+( int			x,
+  int			y,
+  boolean(*func)(line_t*) )
+{
+    return P_BlockLinesIteratorNear(x, y, NULL, func);
+}
+
 
 //
-// P_BlockThingsIterator
+// P_BlockThingsIteratorNear
+// [crispy] Like P_BlockThingsIterator(), but skips the things far()
+// returns true for, which func() has to reject itself without any side
+// effects.
 //
 boolean
-P_BlockThingsIterator
+P_BlockThingsIteratorNear
 ( int			x,
   int			y,
+  boolean(*far)(const blockthing_t*),
   boolean(*func)(mobj_t*) )
 {
     mobj_t*		mobj;
+    blockcell_t*	bc;
+    blockthing_t*	bt;
+    unsigned int	changes;
+    int			i;
 	
     if ( x<0
 	 || y<0
@@ -523,13 +1040,46 @@ P_BlockThingsIterator
 	return true;
     }
     
+    bc = &blockcells[y*bmapwidth+x];
 
-    for (mobj = blocklinks[y*bmapwidth+x] ;
-	 mobj ;
-	 mobj = mobj->bnext)
+    if (bc->diverged)
     {
-	if (!func( mobj ) )
-	    return false;
+	for (mobj = blocklinks[y*bmapwidth+x] ;
+	     mobj ;
+	     mobj = mobj->bnext)
+	{
+	    if (!func( mobj ) )
+		return false;
+	}
+    }
+    else
+    {
+	// [crispy] from the head of the chain
+	for (i = bc->numthings - 1; i >= 0; i--)
+	{
+	    bt = &bc->things[i];
+
+	    if (far && far(bt))
+		continue;
+
+	    mobj = bt->mo;
+	    changes = blocklinkchanges;
+
+	    if (!func( mobj ) )
+		return false;
+
+	    // [crispy] things were linked or unlinked, so carry on along
+	    // the links, the same way as above
+	    if (blocklinkchanges != changes)
+	    {
+		for (mobj = mobj->bnext ; mobj ; mobj = mobj->bnext)
+		{
+		    if (!func( mobj ) )
+			return false;
+		}
+		break;
+	    }
+	}
     }
 
     // [crispy] Blockmap bug fix - add other mobjs from
@@ -649,6 +1199,18 @@ P_BlockThingsIterator
     return true;
 }
 
+//
+// P_BlockThingsIterator
+//
+boolean
+P_BlockThingsIterator
+( int			x,
+  int			y,
+  boolean(*func)(mobj_t*) )
+{
+    return P_BlockThingsIteratorNear(x, y, NULL, func);
+}
+
 
 
 //
@@ -681,6 +1243,35 @@ static void InterceptsOverrun(int num_intercepts, intercept_t *intercept);
 // [crispy] show mapthing number in INTERCEPTS overflow warnings
 extern mobj_t* shootthing;
 
+//
+// PIT_TraceMissesLine
+// [crispy] Lines PIT_AddLineIntercepts() finds not crossed by the trace.
+//
+static boolean PIT_TraceMissesLine (const blockline_t* bl)
+{
+    int			s1;
+    int			s2;
+
+    if ( trace.dx > FRACUNIT*16
+	 || trace.dy > FRACUNIT*16
+	 || trace.dx < -FRACUNIT*16
+	 || trace.dy < -FRACUNIT*16)
+    {
+	s1 = P_PointOnDivlineSide (bl->x1, bl->y1, &trace);
+	s2 = P_PointOnDivlineSide (bl->x2, bl->y2, &trace);
+    }
+    else
+    {
+	s1 = PointOnLineSide (trace.x, trace.y,
+	                      bl->x1, bl->y1, bl->dx, bl->dy);
+	s2 = PointOnLineSide (trace.x+trace.dx, trace.y+trace.dy,
+	                      bl->x1, bl->y1, bl->dx, bl->dy);
+    }
+
+    return s1 == s2;
+}
+
+
 //
 // PIT_AddLineIntercepts.
 // Looks for lines in the given block
@@ -834,46 +1425,77 @@ boolean PIT_AddThingIntercepts (mobj_t* thing)
 // Returns true if the traverser function returns true
 // for all lines.
 // 
+// [crispy] The intercepts are visited through a binary min-heap of
+// their indices instead of searching all of them for the closest one
+// each time.  The heap is ordered by frac and then by index, which is
+// the order vanilla's search visits them in: it takes the first of
+// several at the same frac.
+static int*	interceptheap;
+static int	interceptheapsize;
+
+static inline boolean InterceptBefore (int a, int b)
+{
+    return intercepts[a].frac < intercepts[b].frac
+        || (intercepts[a].frac == intercepts[b].frac && a < b);
+}
+
+static void InterceptSiftDown (int i, int count)
+{
+    int		child;
+    int		top;
+
+    top = interceptheap[i];
+
+    while ((child = 2 * i + 1) < count)
+    {
+	if (child + 1 < count
+	 && InterceptBefore(interceptheap[child + 1], interceptheap[child]))
+	    child++;
+
+	if (!InterceptBefore(interceptheap[child], top))
+	    break;
+
+	interceptheap[i] = interceptheap[child];
+	i = child;
+    }
+
+    interceptheap[i] = top;
+}
+
 boolean
 P_TraverseIntercepts
 ( traverser_t	func,
   fixed_t	maxfrac )
 {
     int			count;
-    fixed_t		dist;
-    intercept_t*	scan;
+    int			i;
     intercept_t*	in;
 	
     count = intercept_p - intercepts;
-    
-    in = 0;			// shut up compiler warning
+
+    if (count > interceptheapsize)
+    {
+	interceptheapsize = count * 2;
+	interceptheap = I_Realloc(interceptheap,
+	                          interceptheapsize * sizeof(*interceptheap));
+    }
+
+    for (i = 0; i < count; i++)
+	interceptheap[i] = i;
+
+    for (i = count / 2 - 1; i >= 0; i--)
+	InterceptSiftDown(i, count);
 	
-    while (count--)
+    while (count)
     {
-	dist = INT_MAX;
-	for (scan = intercepts ; scan<intercept_p ; scan++)
-	{
-	    if (scan->frac < dist)
-	    {
-		dist = scan->frac;
-		in = scan;
-	    }
-	}
+	in = &intercepts[interceptheap[0]];
 	
-	if (dist > maxfrac)
+	if (in->frac > maxfrac)
 	    return true;	// checked everything in range		
 
-#if 0  // UNUSED
-    {
-	// don't check these yet, there may be others inserted
-	in = scan = intercepts;
-	for ( scan = intercepts ; scan<intercept_p ; scan++)
-	    if (scan->frac > maxfrac)
-		*in++ = *scan;
-	intercept_p = in;
-	return false;
-    }
-#endif
+	// take it off the heap
+	interceptheap[0] = interceptheap[--count];
+	InterceptSiftDown(0, count);
 
         if ( !func (in) )
 	    return false;	// don't bother going farther
@@ -1120,7 +1742,7 @@ P_PathTraverse
     {
 	if (flags & PT_ADDLINES)
 	{
-	    if (!P_BlockLinesIterator (mapx, mapy,PIT_AddLineIntercepts))
+	    if (!P_BlockLinesIteratorNear (mapx, mapy,PIT_TraceMissesLine,PIT_AddLineIntercepts))
 		return false;	// early out
 	}
 	
@@ -24,6 +24,7 @@
 
 #include "doomdef.h"
 #include "p_local.h"
+#include "p_profile.h" // [crispy] playsim profiler
 #include "sounds.h"
 
 #include "st_stuff.h"
@@ -79,7 +80,13 @@ P_SetMobjState
 	// Modified handling.
 	// Call action functions when the state is set
 	if (st->action.acp3)
-	    st->action.acp3(mobj, NULL, NULL); // [crispy] let pspr action pointers get called from mobj states
+	{
+	    // [crispy] playsim profiler
+	    if (simprofile)
+		P_ProfileAction(st->action, mobj);
+	    else
+		st->action.acp3(mobj, NULL, NULL); // [crispy] let pspr action pointers get called from mobj states
+	}
 	
 	state = st->nextstate;
 
@@ -540,9 +547,17 @@ static inline void MusInfoThinker (mobj_t *thing)
 	if (musinfo.mapthing != thing &&
 	    thing->subsector->sector == players[displayplayer].mo->subsector->sector)
 	{
+		const int arraypt = thing->health - 1000;
+
 		musinfo.lastmapthing = musinfo.mapthing;
 		musinfo.mapthing = thing;
 		musinfo.tics = leveltime ? 30 : 0;
+
+		// [crispy] read the new track while the change is pending
+		if (arraypt >= 0 && arraypt < MAX_MUS_ENTRIES)
+		{
+			S_PrecacheMusicLump(musinfo.items[arraypt]);
+		}
 	}
 }
 
@@ -663,6 +678,7 @@ P_SpawnMobjSafe
     mobj->height = info->height;
     mobj->flags = info->flags;
     mobj->health = info->spawnhealth;
+    mobj->blockcell = -1; // [crispy] not linked yet
 
     if (gameskill != sk_nightmare)
 	mobj->reactiontime = info->reactiontime;
@@ -732,6 +748,7 @@ P_SpawnMobjSafe
     mobj->thinker.function.acp1 = (actionf_p1)P_MobjThinker;
 	
     P_AddThinker (&mobj->thinker);
+    P_LinkMobjType (mobj);
 
     return mobj;
 }
@@ -746,6 +763,63 @@ P_SpawnMobj
 	return P_SpawnMobjSafe(x, y, z, type, false);
 }
 
+//
+// [crispy] Lists of the mobjs of each type, so that action functions
+// looking for one type do not have to walk every thinker.  Mobjs are
+// added as their thinkers are, so each list is in thinker list order
+// and finds things in the same order as a scan of the thinkers would.
+//
+mobj_t*		mobjtypehead[NUMMOBJTYPES];
+static mobj_t*	mobjtypetail[NUMMOBJTYPES];
+int		mobjtypecount[NUMMOBJTYPES];
+
+void P_ClearMobjTypeLists (void)
+{
+    memset(mobjtypehead, 0, sizeof(mobjtypehead));
+    memset(mobjtypetail, 0, sizeof(mobjtypetail));
+    memset(mobjtypecount, 0, sizeof(mobjtypecount));
+}
+
+// Call right after P_AddThinker for the mobj.
+
+void P_LinkMobjType (mobj_t* mobj)
+{
+    mobjtype_t type = mobj->type;
+
+    mobj->tnext = NULL;
+    mobj->tprev = mobjtypetail[type];
+
+    if (mobjtypetail[type])
+	mobjtypetail[type]->tnext = mobj;
+    else
+	mobjtypehead[type] = mobj;
+
+    mobjtypetail[type] = mobj;
+    mobjtypecount[type]++;
+}
+
+static void P_UnlinkMobjType (mobj_t* mobj)
+{
+    mobjtype_t type = mobj->type;
+
+    // already unlinked?
+    if (!mobj->tprev && mobjtypehead[type] != mobj)
+	return;
+
+    if (mobj->tprev)
+	mobj->tprev->tnext = mobj->tnext;
+    else
+	mobjtypehead[type] = mobj->tnext;
+
+    if (mobj->tnext)
+	mobj->tnext->tprev = mobj->tprev;
+    else
+	mobjtypetail[type] = mobj->tprev;
+
+    mobj->tnext = mobj->tprev = NULL;
+    mobjtypecount[type]--;
+}
+
 //
 // P_RemoveMobj
 //
@@ -773,6 +847,9 @@ void P_RemoveMobj (mobj_t* mobj)
 	
     // unlink from sector and block lists
     P_UnsetThingPosition (mobj);
+
+    // [crispy] and from the list of its type
+    P_UnlinkMobjType (mobj);
     
     // [crispy] removed map objects may finish their sounds
     if (crispy->soundfull)
@@ -1185,6 +1262,7 @@ void P_CheckMissileSpawn (mobj_t* th)
     th->x += (th->momx>>1);
     th->y += (th->momy>>1);
     th->z += (th->momz>>1);
+    P_UpdateBlockThing(th); // [crispy] not relinked
 
     if (!P_TryMove (th, th->x, th->y))
 	P_ExplodeMissile (th);
@@ -296,6 +296,18 @@ typedef struct mobj_s
     fixed_t		oldz;
     angle_t		oldangle;
 
+    // [crispy] Links in the list of mobjs of the same type,
+    // in thinker list order.
+    struct mobj_s*	tnext;
+    struct mobj_s*	tprev;
+
+    // [crispy] sectors touched by the mobj, see P_SetThingPosition()
+    struct msecnode_s*	touching_sectorlist;
+
+    // [crispy] blockcells[] entry of the blocklinks chain the mobj was
+    // last linked into, -1 if none
+    int			blockcell;
+
 } mobj_t;
 
 
@@ -0,0 +1,416 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	[crispy] Playsim profiler.
+//	Times every thinker and every state action, and adds the times
+//	up per function, per mobj type and per map region.  Nothing here
+//	changes the game state, so demos play back the same with the
+//	profiler on.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "deh_bexptr.h"
+#include "doomstat.h"
+#include "i_timer.h"
+#include "m_argv.h"
+#include "m_misc.h"
+#include "p_local.h"
+#include "p_profile.h"
+
+// Map regions are squares of this many map units.
+#define REGIONSHIFT	(FRACBITS + 10)
+
+#define MAXTHINKERFUNCS	64
+#define MAXACTIONS	512
+#define MAXREGIONS	4096
+
+// Number of lines in each part of the report.
+#define REPORTLINES	20
+
+typedef struct
+{
+    uintptr_t		key;	// 0 if unused
+    uint64_t		time;	// in us
+    unsigned int	calls;
+
+    // map regions only
+    int			episode;
+    int			map;
+    int			x;
+    int			y;
+} profentry_t;
+
+boolean	simprofile;
+
+static profentry_t	thinkerprof[MAXTHINKERFUNCS];
+static profentry_t	actionprof[MAXACTIONS];
+static profentry_t	regionprof[MAXREGIONS];
+static profentry_t	mobjtypeprof[NUMMOBJTYPES];
+
+static unsigned int	proftics;
+
+void P_InitProfile (void)
+{
+    //!
+    // @category game
+    //
+    // Time the thinkers and state actions of the playsim, and print a
+    // report per function, mobj type and map region when a demo ends.
+    // Best used with -timedemo.
+    //
+
+    simprofile = M_ParmExists("-simprofile");
+}
+
+// Find the entry for a key, or add it.  Returns NULL if the table is
+// full.
+
+static profentry_t* P_ProfileEntry (profentry_t* table, int size,
+                                    uintptr_t key)
+{
+    int		i;
+    int		n;
+
+    i = (int) ((key * 2654435761u) % (unsigned int) size);
+
+    for (n = 0; n < size; n++)
+    {
+	if (table[i].key == key)
+	    return &table[i];
+
+	if (table[i].key == 0)
+	{
+	    table[i].key = key;
+	    return &table[i];
+	}
+
+	i = (i + 1) % size;
+    }
+
+    return NULL;
+}
+
+static void P_ProfileRegion (fixed_t x, fixed_t y, uint64_t time)
+{
+    profentry_t*	entry;
+    int		rx;
+    int		ry;
+
+    rx = (x - bmaporgx) >> REGIONSHIFT;
+    ry = (y - bmaporgy) >> REGIONSHIFT;
+
+    entry = P_ProfileEntry(regionprof, MAXREGIONS,
+                           ((uintptr_t) gameepisode << 24)
+                         | ((uintptr_t) (gamemap & 0xff) << 16)
+                         | ((uintptr_t) (rx & 0xff) << 8)
+                         | (uintptr_t) (ry & 0xff));
+
+    if (entry)
+    {
+	entry->time += time;
+	entry->calls++;
+	entry->episode = gameepisode;
+	entry->map = gamemap;
+	entry->x = (bmaporgx >> FRACBITS) + (rx << (REGIONSHIFT - FRACBITS));
+	entry->y = (bmaporgy >> FRACBITS) + (ry << (REGIONSHIFT - FRACBITS));
+    }
+}
+
+// The sector a special thinker works on, or NULL.
+
+static sector_t* P_ThinkerSector (thinker_t* th)
+{
+    if (th->function.acp1 == (actionf_p1) T_MoveFloor)
+	return ((floormove_t *) th)->sector;
+    if (th->function.acp1 == (actionf_p1) T_MoveCeiling)
+	return ((ceiling_t *) th)->sector;
+    if (th->function.acp1 == (actionf_p1) T_VerticalDoor)
+	return ((vldoor_t *) th)->sector;
+    if (th->function.acp1 == (actionf_p1) T_PlatRaise)
+	return ((plat_t *) th)->sector;
+    if (th->function.acp1 == (actionf_p1) T_FireFlicker)
+	return ((fireflicker_t *) th)->sector;
+    if (th->function.acp1 == (actionf_p1) T_LightFlash)
+	return ((lightflash_t *) th)->sector;
+    if (th->function.acp1 == (actionf_p1) T_StrobeFlash)
+	return ((strobe_t *) th)->sector;
+    if (th->function.acp1 == (actionf_p1) T_Glow)
+	return ((glow_t *) th)->sector;
+
+    return NULL;
+}
+
+void P_ProfileThinker (thinker_t* thinker)
+{
+    actionf_p1	func;
+    mobj_t*	mobj;
+    sector_t*	sector;
+    fixed_t	x;
+    fixed_t	y;
+    int		type;
+    uint64_t	start;
+    uint64_t	time;
+    profentry_t*	entry;
+
+    func = thinker->function.acp1;
+    type = -1;
+
+    // Note where the thinker is before it runs, as it may remove
+    // itself.
+    if (func == (actionf_p1) P_MobjThinker)
+    {
+	mobj = (mobj_t *) thinker;
+	type = mobj->type;
+	x = mobj->x;
+	y = mobj->y;
+    }
+    else if ((sector = P_ThinkerSector(thinker)) != NULL)
+    {
+	x = sector->soundorg.x;
+	y = sector->soundorg.y;
+    }
+    else
+    {
+	x = y = INT_MIN;
+    }
+
+    start = I_GetTimeUS();
+    func(thinker);
+    time = I_GetTimeUS() - start;
+
+    entry = P_ProfileEntry(thinkerprof, MAXTHINKERFUNCS, (uintptr_t) func);
+
+    if (entry)
+    {
+	entry->time += time;
+	entry->calls++;
+    }
+
+    if (type >= 0)
+    {
+	mobjtypeprof[type].time += time;
+	mobjtypeprof[type].calls++;
+    }
+
+    if (x != INT_MIN)
+	P_ProfileRegion(x, y, time);
+}
+
+// Never called; its address keys the profile entry for the runs of
+// light thinkers, as P_RunLightThinkers() is not a thinker function.
+static void P_LightThinkerRun (void* unused)
+{
+}
+
+void P_ProfileLightThinkers (uint64_t start)
+{
+    profentry_t*	entry;
+
+    entry = P_ProfileEntry(thinkerprof, MAXTHINKERFUNCS,
+                           (uintptr_t) P_LightThinkerRun);
+
+    if (entry)
+    {
+	entry->time += I_GetTimeUS() - start;
+	entry->calls++;
+    }
+}
+
+void P_ProfileAction (actionf_t action, mobj_t* mobj)
+{
+    uint64_t	start;
+    profentry_t*	entry;
+
+    start = I_GetTimeUS();
+    action.acp3(mobj, NULL, NULL);
+
+    entry = P_ProfileEntry(actionprof, MAXACTIONS, (uintptr_t) action.acv);
+
+    if (entry)
+    {
+	entry->time += I_GetTimeUS() - start;
+	entry->calls++;
+    }
+}
+
+void P_ProfileTic (void)
+{
+    proftics++;
+}
+
+//
+// Report
+//
+
+static int P_CompareProfEntries (const void* a, const void* b)
+{
+    const profentry_t*	pa = a;
+    const profentry_t*	pb = b;
+
+    if (pa->time != pb->time)
+	return pa->time < pb->time ? 1 : -1;
+
+    return pa->calls < pb->calls ? 1 : pa->calls > pb->calls ? -1 : 0;
+}
+
+static const char* P_ThinkerName (uintptr_t key)
+{
+    static const struct
+    {
+	actionf_p1	func;
+	const char*	name;
+    } names[] = {
+	{(actionf_p1) P_MobjThinker,		"P_MobjThinker"},
+	{(actionf_p1) T_MoveFloor,		"T_MoveFloor"},
+	{(actionf_p1) T_MoveCeiling,		"T_MoveCeiling"},
+	{(actionf_p1) T_VerticalDoor,		"T_VerticalDoor"},
+	{(actionf_p1) T_PlatRaise,		"T_PlatRaise"},
+	{(actionf_p1) T_FireFlicker,		"T_FireFlicker"},
+	{(actionf_p1) T_LightFlash,		"T_LightFlash"},
+	{(actionf_p1) T_StrobeFlash,		"T_StrobeFlash"},
+	{(actionf_p1) T_Glow,			"T_Glow"},
+	{P_LightThinkerRun,			"P_RunLightThinkers"},
+    };
+    int		i;
+
+    for (i = 0; i < arrlen(names); i++)
+    {
+	if ((uintptr_t) names[i].func == key)
+	    return names[i].name;
+    }
+
+    return "(unknown)";
+}
+
+static void P_PrintProfTable (const char* title, profentry_t* table,
+                              int size, uint64_t total, int kind)
+{
+    profentry_t*	entries;
+    actionf_t	action;
+    const char*	name;
+    char	buf[64];
+    int		num;
+    int		i;
+
+    // sort a copy, so that the table can still be looked up
+    entries = malloc(size * sizeof(*entries));
+    num = 0;
+
+    for (i = 0; i < size; i++)
+    {
+	if (table[i].calls > 0)
+	{
+	    entries[num] = table[i];
+
+	    // the mobj type table is indexed by type
+	    if (kind == 2)
+		entries[num].key = i;
+
+	    num++;
+	}
+    }
+
+    qsort(entries, num, sizeof(*entries), P_CompareProfEntries);
+
+    printf("\n%s:\n", title);
+    printf("  %-28s %10s %10s %8s %6s\n",
+           "", "total ms", "calls", "avg us", "%");
+
+    for (i = 0; i < num && i < REPORTLINES; i++)
+    {
+	switch (kind)
+	{
+	    case 0:
+		name = P_ThinkerName(entries[i].key);
+		break;
+
+	    case 1:
+		action.acv = (actionf_v) entries[i].key;
+		name = DEH_BEXCodePointerName(action);
+		if (name != NULL)
+		{
+		    M_snprintf(buf, sizeof(buf), "A_%s", name);
+		    name = buf;
+		}
+		else
+		{
+		    name = "(unknown)";
+		}
+		break;
+
+	    case 2:
+		M_snprintf(buf, sizeof(buf), "type %d (doomednum %d)",
+		           (int) entries[i].key,
+		           mobjinfo[entries[i].key].doomednum);
+		name = buf;
+		break;
+
+	    default:
+		if (gamemode == commercial)
+		    M_snprintf(buf, sizeof(buf), "MAP%02d (%d, %d)",
+		               entries[i].map, entries[i].x, entries[i].y);
+		else
+		    M_snprintf(buf, sizeof(buf), "E%dM%d (%d, %d)",
+		               entries[i].episode, entries[i].map,
+		               entries[i].x, entries[i].y);
+		name = buf;
+		break;
+	}
+
+	printf("  %-28s %10.1f %10u %8.2f %5.1f%%\n", name,
+	       entries[i].time / 1000.0, entries[i].calls,
+	       (double) entries[i].time / entries[i].calls,
+	       total ? (entries[i].time * 100.0) / total : 0.0);
+    }
+
+    if (num > REPORTLINES)
+	printf("  (%d more)\n", num - REPORTLINES);
+
+    free(entries);
+}
+
+void P_ProfileReport (void)
+{
+    uint64_t	total;
+    int		i;
+
+    if (!simprofile || proftics == 0)
+	return;
+
+    total = 0;
+    for (i = 0; i < MAXTHINKERFUNCS; i++)
+	total += thinkerprof[i].time;
+
+    printf("\nPlaysim profile: %u tics, %.1f ms in thinkers, "
+           "%.1f us per tic\n", proftics, total / 1000.0,
+           (double) total / proftics);
+    printf("Times include everything called from a function, "
+           "so actions are also\ncounted in P_MobjThinker.\n");
+
+    P_PrintProfTable("Thinkers", thinkerprof, MAXTHINKERFUNCS, total, 0);
+    P_PrintProfTable("State actions", actionprof, MAXACTIONS, total, 1);
+    P_PrintProfTable("Mobj types", mobjtypeprof, NUMMOBJTYPES, total, 2);
+    P_PrintProfTable("Map regions (1024x1024 from the south-west corner)",
+                     regionprof, MAXREGIONS, total, 3);
+
+    printf("\n");
+    fflush(stdout);
+
+    // only report once
+    proftics = 0;
+}
@@ -0,0 +1,42 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	[crispy] Playsim profiler.
+//
+
+
+#ifndef __P_PROFILE__
+#define __P_PROFILE__
+
+#include "p_mobj.h"
+
+// Set by -simprofile.
+extern boolean	simprofile;
+
+void P_InitProfile (void);
+
+// Call a thinker or a state action and add the time it takes to the
+// profile.  Only used when simprofile is set.
+void P_ProfileThinker (thinker_t* thinker);
+void P_ProfileAction (actionf_t action, mobj_t* mobj);
+
+// Count the time of a run of light thinkers that P_RunThinkers handed
+// over to P_RunLightThinkers.
+void P_ProfileLightThinkers (uint64_t start);
+
+void P_ProfileTic (void);
+void P_ProfileReport (void);
+
+#endif
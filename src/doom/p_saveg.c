@@ -1648,6 +1648,9 @@ void P_UnArchiveWorld (void)
 	    si->midtexture = saveg_read16();
 	}
     }
+
+    // [crispy] the sector heights have changed
+    P_ClearSightCache();
 }
 
 
@@ -1735,6 +1738,8 @@ void P_UnArchiveThinkers (void)
 	    // [crispy] restore mobj->target and mobj->tracer fields
 	    //mobj->target = NULL;
             //mobj->tracer = NULL;
+	    mobj->touching_sectorlist = NULL; // [crispy] not saved
+	    mobj->blockcell = -1; // [crispy] not saved
 	    P_SetThingPosition (mobj);
 	    mobj->info = &mobjinfo[mobj->type];
 	    // [crispy] killough 2/28/98: Fix for falling down into a wall after savegame loaded
@@ -1742,6 +1747,7 @@ void P_UnArchiveThinkers (void)
 //	    mobj->ceilingz = mobj->subsector->sector->ceilingheight;
 	    mobj->thinker.function.acp1 = (actionf_p1)P_MobjThinker;
 	    P_AddThinker (&mobj->thinker);
+	    P_LinkMobjType (mobj);
 	    break;
 
 	  default:
@@ -37,6 +37,7 @@
 
 #include "doomdef.h"
 #include "p_local.h"
+#include "p_profile.h" // [crispy] P_InitProfile()
 
 #include "s_sound.h"
 #include "s_musinfo.h" // [crispy] S_ParseMusInfo()
@@ -88,11 +89,18 @@ int		bmapheight;	// size in mapblocks
 int32_t*	blockmap;	// int for larger maps // [crispy] BLOCKMAP limit
 // offsets in blockmap are from here
 int32_t*	blockmaplump; // [crispy] BLOCKMAP limit
+int		blockmaplumpsize; // [crispy]
 // origin of block map
 fixed_t		bmaporgx;
 fixed_t		bmaporgy;
 // for thing chains
 mobj_t**	blocklinks;		
+// [crispy] the same chains as arrays
+blockcell_t*	blockcells;
+// [crispy] the line lists as arrays, see P_InitBlockLines()
+blockline_t*	blocklines;
+int*		blocklineoffsets;
+int*		linevalidcount;
 
 
 // REJECT
@@ -755,6 +763,7 @@ boolean P_LoadBlockMap (int lump)
     wadblockmaplump = Z_Malloc(lumplen, PU_LEVEL, NULL);
     W_ReadLump(lump, wadblockmaplump);
     blockmaplump = Z_Malloc(sizeof(*blockmaplump) * count, PU_LEVEL, NULL);
+    blockmaplumpsize = count;
     blockmap = blockmaplump + 4;
 
     blockmaplump[0] = SHORT(wadblockmaplump[0]);
@@ -785,6 +794,10 @@ boolean P_LoadBlockMap (int lump)
     blocklinks = Z_Malloc(count, PU_LEVEL, 0);
     memset(blocklinks, 0, count);
 
+    count = sizeof(*blockcells) * bmapwidth * bmapheight;
+    blockcells = Z_Malloc(count, PU_LEVEL, 0);
+    memset(blockcells, 0, count);
+
     // [crispy] (re-)create BLOCKMAP if necessary
     fprintf(stderr, ")\n");
     return true;
@@ -1179,6 +1192,8 @@ P_SetupLevel
     musinfo.from_savegame = false;
 
     Z_FreeTags (PU_LEVEL, PU_PURGELEVEL-1);
+    // [crispy] the sector touching list nodes are gone, too
+    P_InitSecnodes ();
 
     // UNUSED W_Profile ();
     P_InitThinkers ();
@@ -1272,7 +1287,10 @@ P_SetupLevel
     }
 
     P_GroupLines ();
+    P_InitBlockLines (); // [crispy]
     P_LoadReject (lumpnum+ML_REJECT);
+    // [crispy] sight check cache
+    P_InitSightCache ();
 
     // [crispy] remove slime trails
     P_RemoveSlimeTrails();
@@ -1315,7 +1333,7 @@ P_SetupLevel
     //	UNUSED P_ConnectSubsectors ();
 
     // preload graphics
-    if (precache)
+    if (precache && !headless) // [crispy] nothing is drawn in -headless mode
 	R_PrecacheLevel ();
 
     //printf ("free memory: 0x%x\n", Z_FreeMemory());
@@ -1332,6 +1350,7 @@ void P_Init (void)
     P_InitSwitchList ();
     P_InitPicAnims ();
     R_InitSprites (sprnames);
+    P_InitProfile (); // [crispy] playsim profiler
 }
 
 
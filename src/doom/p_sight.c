@@ -39,6 +39,52 @@ fixed_t		t2y;
 
 int		sightcounts[2];
 
+//
+// [crispy] Sight check cache.  Monsters keep checking sight against
+// the same player from the same spots, so the result of each check is
+// remembered together with the exact positions it was made for.  The
+// cache is direct mapped, indexed by the subsectors of both mobjs and
+// the height of the looker's eyes, and only reports a hit if all the
+// positions match, so it never changes the outcome of a check.
+//
+// Sight also depends on the sector heights, so the cache is flushed
+// whenever a floor or a ceiling moves (see T_MovePlane).  Movers are
+// added to the thinker list after the mobjs of a level, so all the
+// monsters of a tic still share the cache.
+//
+#define SIGHTCACHEBITS	13
+#define SIGHTCACHESIZE	(1 << SIGHTCACHEBITS)
+
+typedef struct
+{
+    unsigned int	generation;
+    fixed_t		t1x, t1y, t1z;
+    fixed_t		t2x, t2y, t2z, t2height;
+    boolean		result;
+} sightcache_t;
+
+static sightcache_t	sightcache[SIGHTCACHESIZE];
+static unsigned int	sightcachegen = 1;
+
+void P_ClearSightCache (void)
+{
+    if (++sightcachegen == 0)
+    {
+	// wrapped around, old entries could match again
+	memset(sightcache, 0, sizeof(sightcache));
+	sightcachegen = 1;
+    }
+}
+
+//
+// P_InitSightCache
+// Called at level load.
+//
+void P_InitSightCache (void)
+{
+    P_ClearSightCache();
+}
+
 
 // PTR_SightTraverse() for Doom 1.2 sight calculations
 // taken from prboom-plus/src/p_sight.c:69-102
@@ -199,10 +245,10 @@ boolean P_CrossSubsector (int num)
 	line = seg->linedef;
 
 	// allready checked other side?
-	if (line->validcount == validcount)
+	if (linevalidcount[line - lines] == validcount)
 	    continue;
 	
-	line->validcount = validcount;
+	linevalidcount[line - lines] = validcount;
 
 	v1 = line->v1;
 	v2 = line->v2;
@@ -345,6 +391,9 @@ P_CheckSight
     int		pnum;
     int		bytenum;
     int		bitnum;
+    sightcache_t*	cache;
+    unsigned int	hash;
+    boolean	result;
     
     // First check for trivial rejection.
 
@@ -380,6 +429,21 @@ P_CheckSight
                               PT_EARLYOUT | PT_ADDLINES, PTR_SightTraverse);
     }
 
+    // [crispy] checked from and to exactly here before?
+    hash = (unsigned int) (t1->subsector - subsectors) * 0x9e3779b1u
+         ^ (unsigned int) (t2->subsector - subsectors) * 0x85ebca77u
+         ^ (unsigned int) (sightzstart >> (FRACBITS + 3)) * 0xc2b2ae3du;
+    cache = &sightcache[hash >> (32 - SIGHTCACHEBITS)];
+
+    if (cache->generation == sightcachegen
+        && cache->t1x == t1->x && cache->t1y == t1->y
+        && cache->t1z == sightzstart
+        && cache->t2x == t2->x && cache->t2y == t2->y
+        && cache->t2z == t2->z && cache->t2height == t2->height)
+    {
+	return cache->result;
+    }
+
     strace.x = t1->x;
     strace.y = t1->y;
     t2x = t2->x;
@@ -388,7 +452,19 @@ P_CheckSight
     strace.dy = t2->y - t1->y;
 
     // the head node is the last node output
-    return P_CrossBSPNode (numnodes-1);	
+    result = P_CrossBSPNode (numnodes-1);
+
+    cache->generation = sightcachegen;
+    cache->t1x = t1->x;
+    cache->t1y = t1->y;
+    cache->t1z = sightzstart;
+    cache->t2x = t2->x;
+    cache->t2y = t2->y;
+    cache->t2z = t2->z;
+    cache->t2height = t2->height;
+    cache->result = result;
+
+    return result;
 }
 
 
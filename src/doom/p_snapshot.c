@@ -0,0 +1,602 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	[crispy] In-memory snapshots of the running level.
+//
+//	A snapshot is a savegame written into memory, followed by the
+//	state a savegame leaves out or rounds: the order of the thinker
+//	list and of the blockmap and sector thing chains, the random
+//	number indices and the full precision sector heights.  Without
+//	them, a demo played on from a restored snapshot goes out of sync.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "doomstat.h"
+#include "i_system.h"
+#include "m_misc.h"
+#include "p_extsaveg.h"
+#include "p_local.h"
+#include "p_saveg.h"
+#include "p_snapshot.h"
+
+#if defined(HAVE_OPEN_MEMSTREAM) && defined(HAVE_FMEMOPEN)
+#define USE_MEMSTREAMS
+#endif
+
+extern int brainspiteasy;
+
+// The savegame writes the mobjs, the specials and the fire flickers
+// into separate sections, so they come back grouped by class.
+
+enum
+{
+    sc_none,
+    sc_mobj,
+    sc_special,
+    sc_flicker,
+    NUMSNAPCLASSES
+};
+
+struct snapshot_s
+{
+    char	*data;		// the savegame
+    size_t	size;
+
+    int		prndindex;
+    int		rndindex;
+    int		brainspiteasy;
+
+    fixed_t	*heights;	// floor and ceiling of each sector
+    int		numsectors;
+
+    byte	*thinkers;	// class of each saved thinker, in list order
+    int		numthinkers;
+
+    int		*links;		// sprev, snext, bprev, bnext of each mobj
+    int		nummobjs;
+
+    player_t	players[MAXPLAYERS];
+    int		attackers[MAXPLAYERS];
+
+    int		bodyque[BODYQUESIZE];
+    int		bodyqueslot;
+
+    mapthing_t	itemrespawnque[ITEMQUESIZE];
+    int		itemrespawntime[ITEMQUESIZE];
+    int		iquehead;
+    int		iquetail;
+};
+
+//
+// STREAMS
+// Without open_memstream() and fmemopen(),
+// go through a temporary file.
+//
+
+#ifndef USE_MEMSTREAMS
+static char *tempfilename;
+#endif
+
+static void OpenWriteStream (snapshot_t *snapshot)
+{
+#ifdef USE_MEMSTREAMS
+    save_stream = open_memstream(&snapshot->data, &snapshot->size);
+#else
+    tempfilename = M_TempFile("snapshot.tmp");
+    save_stream = M_fopen(tempfilename, "w+b");
+#endif
+
+    if (save_stream == NULL)
+    {
+	I_Error ("P_TakeSnapshot: Failed to open a stream");
+    }
+}
+
+static void CloseWriteStream (snapshot_t *snapshot)
+{
+#ifdef USE_MEMSTREAMS
+    fclose(save_stream);
+#else
+    snapshot->size = ftell(save_stream);
+    snapshot->data = malloc(snapshot->size);
+    rewind(save_stream);
+
+    if (fread(snapshot->data, 1, snapshot->size, save_stream) < snapshot->size)
+    {
+	savegame_error = true;
+    }
+
+    fclose(save_stream);
+    M_remove(tempfilename);
+    free(tempfilename);
+#endif
+
+    save_stream = NULL;
+}
+
+static void OpenReadStream (snapshot_t *snapshot)
+{
+#ifdef USE_MEMSTREAMS
+    save_stream = fmemopen(snapshot->data, snapshot->size, "rb");
+#else
+    tempfilename = M_TempFile("snapshot.tmp");
+    save_stream = M_fopen(tempfilename, "w+b");
+
+    if (save_stream != NULL)
+    {
+	fwrite(snapshot->data, 1, snapshot->size, save_stream);
+	rewind(save_stream);
+    }
+#endif
+
+    if (save_stream == NULL)
+    {
+	I_Error ("P_OpenSnapshot: Failed to open a stream");
+    }
+}
+
+static void CloseReadStream (void)
+{
+    fclose(save_stream);
+#ifndef USE_MEMSTREAMS
+    M_remove(tempfilename);
+    free(tempfilename);
+#endif
+
+    save_stream = NULL;
+}
+
+//
+// MOBJ INDICES
+// Numbered from 1 in thinker list order, like P_ThinkerToIndex(),
+// but looked up by binary search instead of walking the list.
+//
+
+typedef struct
+{
+    mobj_t*	mobj;
+    int		index;
+} mobjindex_t;
+
+static mobj_t**		mobjs;
+static mobjindex_t*	mobjindex;
+static int		nummobjs;
+static int		maxmobjs;
+
+static void CollectMobjs (void)
+{
+    thinker_t*	th;
+
+    nummobjs = 0;
+
+    for (th = thinkercap.next; th != &thinkercap; th = th->next)
+    {
+	if (th->function.acp1 != (actionf_p1) P_MobjThinker)
+	    continue;
+
+	if (nummobjs == maxmobjs)
+	{
+	    maxmobjs = maxmobjs ? 2 * maxmobjs : 1024;
+	    mobjs = I_Realloc(mobjs, maxmobjs * sizeof(*mobjs));
+	    mobjindex = I_Realloc(mobjindex, maxmobjs * sizeof(*mobjindex));
+	}
+
+	mobjs[nummobjs++] = (mobj_t *) th;
+    }
+}
+
+static int CompareMobjIndex (const void *a, const void *b)
+{
+    uintptr_t	ma = (uintptr_t) ((const mobjindex_t *) a)->mobj;
+    uintptr_t	mb = (uintptr_t) ((const mobjindex_t *) b)->mobj;
+
+    return (ma > mb) - (ma < mb);
+}
+
+static void SortMobjIndex (void)
+{
+    int		i;
+
+    for (i = 0; i < nummobjs; i++)
+    {
+	mobjindex[i].mobj = mobjs[i];
+	mobjindex[i].index = i + 1;
+    }
+
+    qsort(mobjindex, nummobjs, sizeof(*mobjindex), CompareMobjIndex);
+}
+
+static int MobjToIndex (mobj_t* mobj)
+{
+    mobjindex_t	key;
+    mobjindex_t*	found;
+
+    if (!mobj)
+	return 0;
+
+    key.mobj = mobj;
+    found = bsearch(&key, mobjindex, nummobjs, sizeof(*mobjindex),
+                    CompareMobjIndex);
+
+    return found ? found->index : 0;
+}
+
+static mobj_t* IndexToMobj (int index)
+{
+    if (index < 1 || index > nummobjs)
+	return NULL;
+
+    return mobjs[index - 1];
+}
+
+//
+// ThinkerClass
+// Which section of the savegame a thinker is written to,
+// following P_ArchiveThinkers(), P_ArchiveSpecials() and the
+// "fireflicker" extended savegame data.
+//
+static int ThinkerClass (thinker_t* th)
+{
+    int		i;
+
+    if (th->function.acp1 == (actionf_p1) P_MobjThinker)
+	return sc_mobj;
+
+    if (th->function.acp1 == (actionf_p1) T_FireFlicker)
+	return sc_flicker;
+
+    // ceilings and plats in stasis
+    if (th->function.acv == (actionf_v) NULL)
+    {
+	for (i = 0; i < MAXCEILINGS; i++)
+	    if (activeceilings[i] == (ceiling_t *) th)
+		return sc_special;
+
+	for (i = 0; i < MAXPLATS; i++)
+	    if (activeplats[i] == (plat_t *) th)
+		return sc_special;
+
+	return sc_none;
+    }
+
+    if (th->function.acp1 == (actionf_p1) T_MoveCeiling
+     || th->function.acp1 == (actionf_p1) T_VerticalDoor
+     || th->function.acp1 == (actionf_p1) T_MoveFloor
+     || th->function.acp1 == (actionf_p1) T_PlatRaise
+     || th->function.acp1 == (actionf_p1) T_LightFlash
+     || th->function.acp1 == (actionf_p1) T_StrobeFlash
+     || th->function.acp1 == (actionf_p1) T_Glow)
+	return sc_special;
+
+    return sc_none;
+}
+
+//
+// P_TakeSnapshot
+//
+snapshot_t *P_TakeSnapshot (void)
+{
+    snapshot_t*	snapshot;
+    thinker_t*	th;
+    mobj_t*	mo;
+    int		i;
+    int		c;
+
+    snapshot = calloc(1, sizeof(*snapshot));
+
+    OpenWriteStream(snapshot);
+    savegame_error = false;
+
+    P_WriteSaveGameHeader("snapshot");
+    P_ArchivePlayers ();
+    P_ArchiveWorld ();
+    P_ArchiveThinkers ();
+    P_ArchiveSpecials ();
+    P_WriteSaveGameEOF();
+    P_WriteExtendedSaveGameData();
+
+    CloseWriteStream(snapshot);
+
+    if (savegame_error)
+    {
+	P_FreeSnapshot(snapshot);
+	return NULL;
+    }
+
+    snapshot->prndindex = prndindex;
+    snapshot->rndindex = rndindex;
+    snapshot->brainspiteasy = brainspiteasy;
+
+    snapshot->numsectors = numsectors;
+    snapshot->heights = malloc(2 * numsectors * sizeof(*snapshot->heights));
+
+    for (i = 0; i < numsectors; i++)
+    {
+	snapshot->heights[2 * i] = sectors[i].floorheight;
+	snapshot->heights[2 * i + 1] = sectors[i].ceilingheight;
+    }
+
+    // the order of the thinker list decides the order of the
+    // P_Random() calls, keep it
+    snapshot->numthinkers = 0;
+    for (th = thinkercap.next; th != &thinkercap; th = th->next)
+	snapshot->numthinkers++;
+
+    snapshot->thinkers = malloc(snapshot->numthinkers);
+    snapshot->numthinkers = 0;
+
+    for (th = thinkercap.next; th != &thinkercap; th = th->next)
+    {
+	if ((c = ThinkerClass(th)) != sc_none)
+	    snapshot->thinkers[snapshot->numthinkers++] = c;
+    }
+
+    // so do the orders of the chains that the blockmap
+    // and sector iterators walk
+    CollectMobjs();
+    SortMobjIndex();
+
+    snapshot->nummobjs = nummobjs;
+    snapshot->links = malloc(4 * nummobjs * sizeof(*snapshot->links));
+
+    for (i = 0; i < nummobjs; i++)
+    {
+	mo = mobjs[i];
+	snapshot->links[4 * i] = MobjToIndex(mo->sprev);
+	snapshot->links[4 * i + 1] = MobjToIndex(mo->snext);
+	snapshot->links[4 * i + 2] = MobjToIndex(mo->bprev);
+	snapshot->links[4 * i + 3] = MobjToIndex(mo->bnext);
+    }
+
+    // player_t has more fields than the savegame stores
+    memcpy(snapshot->players, players, sizeof(players));
+
+    for (i = 0; i < MAXPLAYERS; i++)
+	snapshot->attackers[i] = MobjToIndex(players[i].attacker);
+
+    for (i = 0; i < BODYQUESIZE; i++)
+	snapshot->bodyque[i] = MobjToIndex(bodyque[i]);
+
+    snapshot->bodyqueslot = bodyqueslot;
+
+    memcpy(snapshot->itemrespawnque, itemrespawnque, sizeof(itemrespawnque));
+    memcpy(snapshot->itemrespawntime, itemrespawntime, sizeof(itemrespawntime));
+    snapshot->iquehead = iquehead;
+    snapshot->iquetail = iquetail;
+
+    return snapshot;
+}
+
+//
+// P_OpenSnapshot
+//
+boolean P_OpenSnapshot (snapshot_t *snapshot)
+{
+    OpenReadStream(snapshot);
+    savegame_error = false;
+
+    if (!P_ReadSaveGameHeader())
+    {
+	CloseReadStream();
+	return false;
+    }
+
+    return true;
+}
+
+//
+// RelinkThinkers
+// The restored thinkers come grouped by class, each class in
+// the right order.  Merge them back into the saved sequence.
+//
+static void RelinkThinkers (snapshot_t *snapshot)
+{
+    thinker_t*	th;
+    thinker_t*	prev;
+    thinker_t**	sorted;
+    int		count[NUMSNAPCLASSES];
+    int		start[NUMSNAPCLASSES];
+    int		numthinkers;
+    int		i;
+    int		c;
+
+    memset(count, 0, sizeof(count));
+    numthinkers = 0;
+
+    for (th = thinkercap.next; th != &thinkercap; th = th->next)
+    {
+	count[ThinkerClass(th)]++;
+	numthinkers++;
+    }
+
+    for (i = 0; i < snapshot->numthinkers; i++)
+	count[snapshot->thinkers[i]]--;
+
+    for (c = 0; c < NUMSNAPCLASSES; c++)
+    {
+	if (count[c])
+	{
+	    fprintf(stderr, "P_LoadSnapshot: Thinkers do not match, "
+	                    "keeping the load order.\n");
+	    return;
+	}
+    }
+
+    // sort the list by class, keeping the order within each class
+    for (i = 0; i < snapshot->numthinkers; i++)
+	count[snapshot->thinkers[i]]++;
+
+    for (c = 0, i = 0; c < NUMSNAPCLASSES; c++)
+    {
+	start[c] = i;
+	i += count[c];
+    }
+
+    sorted = malloc(numthinkers * sizeof(*sorted));
+
+    for (th = thinkercap.next; th != &thinkercap; th = th->next)
+	sorted[start[ThinkerClass(th)]++] = th;
+
+    for (c = NUMSNAPCLASSES - 1; c >= 0; c--)
+	start[c] -= count[c];
+
+    prev = &thinkercap;
+
+    for (i = 0; i < snapshot->numthinkers; i++)
+    {
+	th = sorted[start[snapshot->thinkers[i]]++];
+	prev->next = th;
+	th->prev = prev;
+	prev = th;
+    }
+
+    prev->next = &thinkercap;
+    thinkercap.prev = prev;
+
+    free(sorted);
+}
+
+//
+// RelinkMobjs
+// P_SetThingPosition() pushes every restored mobj to the front of
+// its chains, so set the links from the snapshot instead.
+//
+static void RelinkMobjs (snapshot_t *snapshot)
+{
+    mobj_t*	mo;
+    int*	links;
+    int		blockx;
+    int		blocky;
+    int		i;
+
+    if (nummobjs != snapshot->nummobjs)
+    {
+	fprintf(stderr, "P_LoadSnapshot: Mobjs do not match, "
+	                "keeping the load order.\n");
+	return;
+    }
+
+    for (i = 0; i < nummobjs; i++)
+    {
+	mo = mobjs[i];
+	links = &snapshot->links[4 * i];
+
+	if (!(mo->flags & MF_NOSECTOR))
+	{
+	    mo->sprev = IndexToMobj(links[0]);
+	    mo->snext = IndexToMobj(links[1]);
+
+	    if (!mo->sprev)
+		mo->subsector->sector->thinglist = mo;
+	}
+
+	if (!(mo->flags & MF_NOBLOCKMAP))
+	{
+	    blockx = (mo->x - bmaporgx)>>MAPBLOCKSHIFT;
+	    blocky = (mo->y - bmaporgy)>>MAPBLOCKSHIFT;
+
+	    if (blockx>=0
+		&& blockx < bmapwidth
+		&& blocky>=0
+		&& blocky < bmapheight)
+	    {
+		mo->bprev = IndexToMobj(links[2]);
+		mo->bnext = IndexToMobj(links[3]);
+
+		if (!mo->bprev)
+		    blocklinks[blocky*bmapwidth+blockx] = mo;
+	    }
+	}
+    }
+
+    P_RebuildBlockThings();
+}
+
+//
+// P_LoadSnapshot
+// Call after G_InitNew() has loaded the level the header names.
+//
+void P_LoadSnapshot (snapshot_t *snapshot)
+{
+    mobj_t*	mo;
+    mobj_t*	so;
+    int		i;
+
+    P_UnArchivePlayers ();
+    P_UnArchiveWorld ();
+    P_UnArchiveThinkers ();
+    P_UnArchiveSpecials ();
+    P_RestoreTargets ();
+
+    if (!P_ReadSaveGameEOF())
+	I_Error ("Bad snapshot");
+
+    P_ReadExtendedSaveGameData(1);
+
+    CloseReadStream();
+
+    prndindex = snapshot->prndindex;
+    rndindex = snapshot->rndindex;
+    brainspiteasy = snapshot->brainspiteasy;
+
+    for (i = 0; i < numsectors && i < snapshot->numsectors; i++)
+    {
+	sectors[i].floorheight = snapshot->heights[2 * i];
+	sectors[i].ceilingheight = snapshot->heights[2 * i + 1];
+    }
+
+    P_ClearSightCache();
+
+    RelinkThinkers(snapshot);
+
+    CollectMobjs();
+    RelinkMobjs(snapshot);
+
+    for (i = 0; i < MAXPLAYERS; i++)
+    {
+	if (!playeringame[i])
+	    continue;
+
+	mo = players[i].mo;
+	so = players[i].so;
+	players[i] = snapshot->players[i];
+	players[i].mo = mo;
+	players[i].so = so;
+	players[i].attacker = IndexToMobj(snapshot->attackers[i]);
+    }
+
+    for (i = 0; i < BODYQUESIZE; i++)
+	bodyque[i] = IndexToMobj(snapshot->bodyque[i]);
+
+    bodyqueslot = snapshot->bodyqueslot;
+
+    memcpy(itemrespawnque, snapshot->itemrespawnque, sizeof(itemrespawnque));
+    memcpy(itemrespawntime, snapshot->itemrespawntime, sizeof(itemrespawntime));
+    iquehead = snapshot->iquehead;
+    iquetail = snapshot->iquetail;
+}
+
+void P_FreeSnapshot (snapshot_t *snapshot)
+{
+    free(snapshot->data);
+    free(snapshot->heights);
+    free(snapshot->thinkers);
+    free(snapshot->links);
+    free(snapshot);
+}
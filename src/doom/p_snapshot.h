@@ -0,0 +1,38 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	[crispy] In-memory snapshots of the running level.
+//
+
+
+#ifndef __P_SNAPSHOT__
+#define __P_SNAPSHOT__
+
+#include "doomtype.h"
+
+typedef struct snapshot_s snapshot_t;
+
+// Write the level into memory with the savegame serializers, plus
+// everything a savegame leaves out that the playsim depends on.
+snapshot_t *P_TakeSnapshot (void);
+
+// Restoring is split around G_InitNew(), like G_DoLoadGame():
+// P_OpenSnapshot() reads the savegame header, P_LoadSnapshot() the rest.
+boolean P_OpenSnapshot (snapshot_t *snapshot);
+void P_LoadSnapshot (snapshot_t *snapshot);
+
+void P_FreeSnapshot (snapshot_t *snapshot);
+
+#endif
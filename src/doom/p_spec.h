@@ -183,6 +183,7 @@ typedef struct
 #define SLOWDARK			35
 
 void    P_SpawnFireFlicker (sector_t* sector);
+void    T_FireFlicker (fireflicker_t* flick);
 void    T_LightFlash (lightflash_t* flash);
 void    P_SpawnLightFlash (sector_t* sector);
 void    T_StrobeFlash (strobe_t* flash);
@@ -204,6 +205,10 @@ EV_LightTurnOn
 void    T_Glow(glow_t* g);
 void    P_SpawnGlowingLight(sector_t* sector);
 
+// [crispy] parallel light thinkers
+boolean P_IsLightThinker (thinker_t* th);
+thinker_t* P_RunLightThinkers (thinker_t* first);
+
 
 
 
@@ -49,7 +49,6 @@ EV_Teleport
     mobj_t*	m;
     mobj_t*	fog;
     unsigned	an;
-    thinker_t*	thinker;
     sector_t*	sector;
     fixed_t	oldx;
     fixed_t	oldy;
@@ -70,20 +69,9 @@ EV_Teleport
     {
 	if (sectors[ i ].tag == tag )
 	{
-	    for (thinker = thinkercap.next;
-		 thinker != &thinkercap;
-		 thinker = thinker->next)
+	    // [crispy] only look at teleportmen, not every thinker
+	    for (m = mobjtypehead[MT_TELEPORTMAN]; m; m = m->tnext)
 	    {
-		// not a mobj
-		if (thinker->function.acp1 != (actionf_p1)P_MobjThinker)
-		    continue;	
-
-		m = (mobj_t *)thinker;
-		
-		// not a teleportman
-		if (m->type != MT_TELEPORTMAN )
-		    continue;		
-
 		sector = m->subsector->sector;
 		// wrong sector
 		if (sector-sectors != i )
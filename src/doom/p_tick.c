@@ -19,7 +19,10 @@
 
 
 #include "z_zone.h"
+#include "m_argv.h"
+#include "i_timer.h"
 #include "p_local.h"
+#include "p_profile.h"
 #include "s_musinfo.h" // [crispy] T_MAPMusic()
 
 #include "doomstat.h"
@@ -44,9 +47,25 @@ thinker_t	thinkercap;
 //
 // P_InitThinkers
 //
+// [crispy] run light thinkers on several threads
+static boolean parallellights;
+
 void P_InitThinkers (void)
 {
     thinkercap.prev = thinkercap.next  = &thinkercap;
+
+    //!
+    // @category game
+    //
+    // Run runs of light thinkers (flickering, flashing, strobing and
+    // glowing sectors) on several threads.  The results are the same
+    // as running them one after another.
+    //
+
+    parallellights = M_ParmExists("-parallellights");
+
+    // [crispy] the mobjs on the lists are gone along with their thinkers
+    P_ClearMobjTypeLists();
 }
 
 
@@ -107,10 +126,28 @@ void P_RunThinkers (void)
 	    currentthinker->prev->next = currentthinker->next;
 	    Z_Free(currentthinker);
 	}
+	else if (parallellights && P_IsLightThinker(currentthinker))
+	{
+	    // [crispy] a run of light thinkers at once
+	    if (simprofile)
+	    {
+		uint64_t start = I_GetTimeUS();
+		nextthinker = P_RunLightThinkers(currentthinker);
+		P_ProfileLightThinkers(start);
+	    }
+	    else
+		nextthinker = P_RunLightThinkers(currentthinker);
+	}
 	else
 	{
 	    if (currentthinker->function.acp1)
-		currentthinker->function.acp1 (currentthinker);
+	    {
+		// [crispy] playsim profiler
+		if (simprofile)
+		    P_ProfileThinker(currentthinker);
+		else
+		    currentthinker->function.acp1 (currentthinker);
+	    }
             nextthinker = currentthinker->next;
 	}
 	currentthinker = nextthinker;
@@ -149,6 +186,10 @@ void P_Ticker (void)
 	    P_PlayerThink (&players[i]);
 			
     P_RunThinkers ();
+
+    // [crispy] playsim profiler
+    if (simprofile)
+	P_ProfileTic();
     P_UpdateSpecials ();
     P_RespawnSpecials ();
 
@@ -1270,6 +1270,24 @@ void R_InitData (void)
 #endif
 }
 
+//
+// R_InitPlaysimData
+// [crispy] The part of R_InitData() the playsim depends on, for -headless:
+// texture names and heights, flat numbers and the sprite lump range used
+// by R_InitSprites() and P_SpawnMobj(). Sprite dimensions, colormaps and
+// the translucency map are only needed for drawing.
+//
+void R_InitPlaysimData (void)
+{
+    R_InitFlats ();
+    R_InitBrightmaps ();
+    R_InitTextures ();
+
+    firstspritelump = W_GetNumForName (DEH_String("S_START")) + 1;
+    lastspritelump = W_GetNumForName (DEH_String("S_END")) - 1;
+    numspritelumps = lastspritelump - firstspritelump + 1;
+}
+
 
 
 //
@@ -43,6 +43,7 @@ R_GetColumnMod
 
 // I/O, setting up the stuff.
 void R_InitData (void);
+void R_InitPlaysimData (void); // [crispy] -headless
 void R_PrecacheLevel (void);
 
 
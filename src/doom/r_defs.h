@@ -129,6 +129,9 @@ typedef	struct
     // list of mobjs in sector
     mobj_t*	thinglist;
 
+    // [crispy] list of mobjs touching the sector
+    struct msecnode_s*	touching_thinglist;
+
     // thinker_t for reversable actions
     void*	specialdata;
 
@@ -167,6 +170,20 @@ typedef	struct
     short	rlightlevel;
 } sector_t;
 
+//
+// [crispy] A link between a mobj and a sector it touches.  Each node
+// is in two lists: the sectors touched by the mobj, and the mobjs
+// touching the sector.
+//
+typedef struct msecnode_s
+{
+    sector_t*			m_sector;
+    mobj_t*			m_thing;
+    struct msecnode_s*	m_tnext;	// next sector of the mobj
+    struct msecnode_s*	m_sprev;	// prev mobj in the sector
+    struct msecnode_s*	m_snext;	// next mobj in the sector
+} msecnode_t;
+
 
 
 
@@ -242,8 +259,7 @@ typedef struct line_s
     sector_t*	frontsector;
     sector_t*	backsector;
 
-    // if == validcount, already checked
-    int		validcount;
+    // [crispy] validcount moved to linevalidcount[]
 
     // thinker_t for reversable actions
     void*	specialdata;		
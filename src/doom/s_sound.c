@@ -79,6 +79,7 @@ typedef struct
 } channel_t;
 
 // The set of channels available
+// [crispy] stays NULL in -headless mode, which never calls S_Init()
 
 static channel_t *channels;
 static degenmobj_t *sobjs;
@@ -357,25 +358,12 @@ static void S_StopChannel(int cnum)
 //
 static short prevmap = -1;
 
-void S_Start(void)
+// Music for the given level.
+
+static int S_LevelMusic(int episode, int map)
 {
-    int cnum;
     int mnum;
 
-    // kill all playing sounds at start of level
-    //  (trust me - a good idea)
-    for (cnum=0 ; cnum<snd_channels ; cnum++)
-    {
-        if (channels[cnum].sfxinfo)
-        {
-            S_StopChannel(cnum);
-        }
-    }
-
-    // start new music for the level
-    if (musicVolume) // [crispy] do not reset pause state at zero music volume
-    mus_paused = 0;
-
     if (gamemode == commercial)
     {
         const int nmus[] =
@@ -391,13 +379,13 @@ void S_Start(void)
             mus_ddtbl2,
         };
 
-        if ((gameepisode == 2 || gamemission == pack_nerve) &&
-            gamemap <= arrlen(nmus))
+        if ((episode == 2 || gamemission == pack_nerve) &&
+            map <= arrlen(nmus))
         {
-            mnum = nmus[gamemap - 1];
+            mnum = nmus[map - 1];
         }
         else
-        mnum = mus_runnin + gamemap - 1;
+        mnum = mus_runnin + map - 1;
     }
     else
     {
@@ -416,17 +404,17 @@ void S_Start(void)
             mus_e1m9,        // Tim          e4m9
         };
 
-        if (gameepisode < 4 || gameepisode == 5) // [crispy] Sigil
+        if (episode < 4 || episode == 5) // [crispy] Sigil
         {
-            mnum = mus_e1m1 + (gameepisode-1)*9 + gamemap-1;
+            mnum = mus_e1m1 + (episode-1)*9 + map-1;
         }
         else
         {
-            mnum = spmus[gamemap-1];
+            mnum = spmus[map-1];
 
             // [crispy] support dedicated music tracks for the 4th episode
             {
-                const int sp_mnum = mus_e1m1 + 3 * 9 + gamemap - 1;
+                const int sp_mnum = mus_e1m1 + 3 * 9 + map - 1;
 
                 if (S_music[sp_mnum].lumpnum > 0)
                 {
@@ -436,6 +424,35 @@ void S_Start(void)
         }
     }
 
+    return mnum;
+}
+
+void S_Start(void)
+{
+    int cnum;
+    int mnum;
+
+    if (!channels)
+    {
+        return;
+    }
+
+    // kill all playing sounds at start of level
+    //  (trust me - a good idea)
+    for (cnum=0 ; cnum<snd_channels ; cnum++)
+    {
+        if (channels[cnum].sfxinfo)
+        {
+            S_StopChannel(cnum);
+        }
+    }
+
+    // start new music for the level
+    if (musicVolume) // [crispy] do not reset pause state at zero music volume
+    mus_paused = 0;
+
+    mnum = S_LevelMusic(gameepisode, gamemap);
+
     // [crispy] do not change music if not changing map (preserves IDMUS choice)
     {
 	const short curmap = (gameepisode << 8) + gamemap;
@@ -456,6 +473,11 @@ void S_StopSound(mobj_t *origin)
 {
     int cnum;
 
+    if (!channels)
+    {
+        return;
+    }
+
     for (cnum=0 ; cnum<snd_channels ; cnum++)
     {
         if (channels[cnum].sfxinfo && channels[cnum].origin == origin)
@@ -477,7 +499,7 @@ void S_UnlinkSound(mobj_t *origin)
 {
     int cnum;
 
-    if (origin)
+    if (origin && channels)
     {
         for (cnum=0 ; cnum<snd_channels ; cnum++)
         {
@@ -660,7 +682,7 @@ void S_StartSound(void *origin_p, int sfx_id)
     volume = snd_SfxVolume;
 
     // [crispy] make non-fatal, consider zero volume
-    if (sfx_id == sfx_None || !snd_SfxVolume || (nodrawers && singletics))
+    if (sfx_id == sfx_None || !snd_SfxVolume || (nodrawers && singletics) || !channels)
     {
         return;
     }
@@ -761,6 +783,11 @@ void S_StartSoundOnce (void *origin_p, int sfx_id)
     int cnum;
     const sfxinfo_t *const sfx = &S_sfx[sfx_id];
 
+    if (!channels)
+    {
+        return;
+    }
+
     for (cnum = 0; cnum < snd_channels; cnum++)
     {
         if (channels[cnum].sfxinfo == sfx &&
@@ -821,6 +848,11 @@ void S_UpdateSounds(mobj_t *listener)
     sfxinfo_t*        sfx;
     channel_t*        c;
 
+    if (!channels)
+    {
+        return;
+    }
+
     I_UpdateSound();
 
     for (cnum=0; cnum<snd_channels; cnum++)
@@ -1024,6 +1056,51 @@ void S_ChangeMusic(int musicnum, int looping)
     }
 }
 
+// [crispy] hint the music system that a music lump will be played soon
+
+void S_PrecacheMusicLump(int lumpnum)
+{
+    void *data;
+    int len;
+
+    // only music pack tracks are loaded ahead of time, so without them
+    // there is no point in reading the lump in the middle of play
+    if (lumpnum <= 0 || (nodrawers && singletics) || !I_MusicPacksActive())
+    {
+        return;
+    }
+
+    // read into a buffer of our own: going through the lump cache would
+    // leave the lump purgable, and it may be the song that is playing
+    len = W_LumpLength(lumpnum);
+    data = Z_Malloc(len, PU_STATIC, NULL);
+    W_ReadLump(lumpnum, data);
+    I_PrecacheSong(data, len);
+    Z_Free(data);
+}
+
+void S_PrecacheLevelMusic(int episode, int map)
+{
+    const int musicnum = S_LevelMusic(episode, map);
+    char namebuf[9];
+
+    if (musicnum <= mus_None || musicnum >= NUMMUSIC)
+    {
+        return;
+    }
+
+    if (S_music[musicnum].lumpnum)
+    {
+        S_PrecacheMusicLump(S_music[musicnum].lumpnum);
+    }
+    else
+    {
+        M_snprintf(namebuf, sizeof(namebuf), "d_%s",
+                   DEH_String(S_music[musicnum].name));
+        S_PrecacheMusicLump(W_CheckNumForName(namebuf));
+    }
+}
+
 // [crispy] adapted from prboom-plus/src/s_sound.c:552-590
 
 void S_ChangeMusInfoMusic (int lumpnum, int looping)
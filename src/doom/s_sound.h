@@ -67,6 +67,11 @@ void S_StartMusic(int music_id);
 void S_ChangeMusic(int music_id, int looping);
 void S_ChangeMusInfoMusic(int lumpnum, int looping);
 
+// Hint that music is likely to be played soon, so that it can be
+//  loaded ahead of time.
+void S_PrecacheMusicLump(int lumpnum);
+void S_PrecacheLevelMusic(int episode, int map);
+
 // query if music is playing
 boolean S_MusicPlaying(void);
 
@@ -1678,6 +1678,9 @@ void WI_Ticker(void)
 	  S_ChangeMusic(mus_sigint, true);
 	else
 	  S_ChangeMusic(mus_inter, true); 
+
+	// [crispy] get the next level's music ready while we wait here
+	S_PrecacheLevelMusic(wbs->epsd + 1, wbs->next + 1);
     }
 
     WI_checkForAccelerate();
@@ -0,0 +1,160 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      [crispy] Expansion of the 8-bit screen buffer to 32-bit pixels.
+//
+//      Each row is expanded by the fastest kernel the CPU supports,
+//      picked at startup.  Large screens are split into bands of rows
+//      that the worker threads of i_parallel.c expand at the same time.
+//
+
+#include "SDL.h"
+
+#include "doomtype.h"
+#include "i_expand.h"
+#include "i_parallel.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) \
+ && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_AVX2_KERNEL
+#include <immintrin.h>
+#endif
+
+// Screens with fewer pixels than this are not worth splitting up.
+
+#define MIN_THREADED_PIXELS (640 * 400)
+
+typedef void (*expand_row_t)(const byte *src, uint32_t *dest, int width,
+                             const uint32_t *lut);
+
+static expand_row_t ExpandRow;
+
+// Parameters shared by all bands of the current image.
+
+static const byte *expand_src;
+static byte *expand_dest;
+static int expand_src_pitch, expand_dest_pitch, expand_width;
+static const uint32_t *expand_lut;
+
+static void ExpandRow_Generic(const byte *src, uint32_t *dest, int width,
+                              const uint32_t *lut)
+{
+    int x;
+
+    // Eight at a time, so the loads can be overlapped.
+
+    for (x = 0; x + 8 <= width; x += 8)
+    {
+        dest[x]     = lut[src[x]];
+        dest[x + 1] = lut[src[x + 1]];
+        dest[x + 2] = lut[src[x + 2]];
+        dest[x + 3] = lut[src[x + 3]];
+        dest[x + 4] = lut[src[x + 4]];
+        dest[x + 5] = lut[src[x + 5]];
+        dest[x + 6] = lut[src[x + 6]];
+        dest[x + 7] = lut[src[x + 7]];
+    }
+
+    for (; x < width; ++x)
+    {
+        dest[x] = lut[src[x]];
+    }
+}
+
+#ifdef HAVE_AVX2_KERNEL
+__attribute__((target("avx2")))
+static void ExpandRow_AVX2(const byte *src, uint32_t *dest, int width,
+                           const uint32_t *lut)
+{
+    __m128i indexes;
+    __m256i lo, hi;
+    int x;
+
+    // Sixteen pixels at a time: widen the indexes to 32 bits and
+    // gather the table entries.
+
+    for (x = 0; x + 16 <= width; x += 16)
+    {
+        indexes = _mm_loadu_si128((const __m128i *) (src + x));
+        lo = _mm256_cvtepu8_epi32(indexes);
+        hi = _mm256_cvtepu8_epi32(_mm_srli_si128(indexes, 8));
+
+        _mm256_storeu_si256((__m256i *) (dest + x),
+                            _mm256_i32gather_epi32((const int *) lut, lo, 4));
+        _mm256_storeu_si256((__m256i *) (dest + x + 8),
+                            _mm256_i32gather_epi32((const int *) lut, hi, 4));
+    }
+
+    for (; x < width; ++x)
+    {
+        dest[x] = lut[src[x]];
+    }
+}
+#endif
+
+// Expand rows start to end-1 of the current image.
+
+static void ExpandRows(void *unused, int start, int end)
+{
+    const byte *src;
+    byte *dest;
+    int y;
+
+    src = expand_src + start * expand_src_pitch;
+    dest = expand_dest + start * expand_dest_pitch;
+
+    for (y = start; y < end; ++y)
+    {
+        ExpandRow(src, (uint32_t *) dest, expand_width, expand_lut);
+        src += expand_src_pitch;
+        dest += expand_dest_pitch;
+    }
+}
+
+void I_InitExpand(void)
+{
+    ExpandRow = ExpandRow_Generic;
+
+#ifdef HAVE_AVX2_KERNEL
+    if (SDL_HasAVX2())
+    {
+        ExpandRow = ExpandRow_AVX2;
+    }
+#endif
+
+    // Start the worker threads now, rather than on the first frame.
+
+    I_InitParallel();
+}
+
+void I_ExpandIndexed(const byte *src, int src_pitch,
+                     void *dest, int dest_pitch,
+                     int width, int height, const uint32_t *lut)
+{
+    expand_src = src;
+    expand_dest = dest;
+    expand_src_pitch = src_pitch;
+    expand_dest_pitch = dest_pitch;
+    expand_width = width;
+    expand_lut = lut;
+
+    if (width * height >= MIN_THREADED_PIXELS)
+    {
+        I_ParallelFor(ExpandRows, NULL, height);
+    }
+    else
+    {
+        ExpandRows(NULL, 0, height);
+    }
+}
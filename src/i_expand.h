@@ -0,0 +1,31 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      [crispy] Expansion of the 8-bit screen buffer to 32-bit pixels.
+//
+
+#ifndef __I_EXPAND__
+#define __I_EXPAND__
+
+#include "doomtype.h"
+
+void I_InitExpand(void);
+
+// Look up every pixel of an 8-bit image in a 256-entry table of
+// 32-bit pixels.  Pitches are in bytes.
+void I_ExpandIndexed(const byte *src, int src_pitch,
+                     void *dest, int dest_pitch,
+                     int width, int height, const uint32_t *lut);
+
+#endif
@@ -137,6 +137,53 @@ static unsigned int current_track_pos;
 // Currently playing music track.
 static Mix_Music *current_track_music = NULL;
 
+// Substitute tracks that the game expects to play soon are read into
+// memory ahead of time by a background thread, along with their loop
+// metadata, so that switching tracks does not hit the disk.
+
+#define MAX_PRELOADED_TRACKS 4
+
+// Larger files are left on disk; only their metadata is cached.
+
+#define MAX_PRELOAD_SIZE (32 * 1024 * 1024)
+
+typedef enum
+{
+    PRELOAD_EMPTY,
+    PRELOAD_QUEUED,
+    PRELOAD_LOADING,
+    PRELOAD_READY,
+} preload_state_t;
+
+typedef struct
+{
+    preload_state_t state;
+    char *filename;
+
+    // File contents, or NULL if the file was too large to keep.
+    void *data;
+    size_t data_len;
+
+#if !USE_SDL_MIXER_LOOPING
+    file_metadata_t metadata;
+#endif
+
+    // Song currently playing from data, which must stay around until
+    // the song is unregistered.
+    Mix_Music *music;
+
+    unsigned int last_used;
+} preload_t;
+
+static preload_t preloads[MAX_PRELOADED_TRACKS];
+static unsigned int preload_counter = 0;
+
+// Protects preload state changes between the game and preload thread.
+static SDL_mutex *preload_mutex = NULL;
+static SDL_sem *preload_sem = NULL;
+static SDL_Thread *preload_thread = NULL;
+static SDL_atomic_t preload_running;
+
 // If true, the currently playing track is being played on loop.
 static boolean current_track_loop;
 
@@ -713,6 +760,180 @@ static const char *GetSubstituteMusicFile(void *data, size_t data_len)
     return filename;
 }
 
+// Read a whole file into memory. Returns false if the file could not be
+// read or is too large to keep around.
+
+static boolean ReadPreloadFile(const char *filename, void **data,
+                               size_t *data_len)
+{
+    FILE *fs;
+    long len;
+    void *buf;
+
+    fs = M_fopen(filename, "rb");
+
+    if (fs == NULL)
+    {
+        return false;
+    }
+
+    len = M_FileLength(fs);
+
+    if (len <= 0 || len > MAX_PRELOAD_SIZE)
+    {
+        fclose(fs);
+        return false;
+    }
+
+    buf = malloc(len);
+
+    if (buf == NULL || fread(buf, 1, len, fs) < len)
+    {
+        free(buf);
+        fclose(fs);
+        return false;
+    }
+
+    fclose(fs);
+
+    *data = buf;
+    *data_len = len;
+
+    return true;
+}
+
+// Background thread that loads queued tracks.
+
+static int PreloadThread(void *unused)
+{
+    preload_t *preload;
+    int i;
+
+    for (;;)
+    {
+        SDL_SemWait(preload_sem);
+
+        if (!SDL_AtomicGet(&preload_running))
+        {
+            break;
+        }
+
+        for (i = 0; i < MAX_PRELOADED_TRACKS; ++i)
+        {
+            preload = &preloads[i];
+
+            SDL_LockMutex(preload_mutex);
+            if (preload->state != PRELOAD_QUEUED)
+            {
+                SDL_UnlockMutex(preload_mutex);
+                continue;
+            }
+            preload->state = PRELOAD_LOADING;
+            SDL_UnlockMutex(preload_mutex);
+
+            // Loading slots are never evicted, so we can work on this
+            // one without holding the lock.
+
+            if (!ReadPreloadFile(preload->filename, &preload->data,
+                                 &preload->data_len))
+            {
+                preload->data = NULL;
+                preload->data_len = 0;
+            }
+
+#if !USE_SDL_MIXER_LOOPING
+            ReadLoopPoints(preload->filename, &preload->metadata);
+#endif
+
+            SDL_LockMutex(preload_mutex);
+            preload->state = PRELOAD_READY;
+            SDL_UnlockMutex(preload_mutex);
+        }
+    }
+
+    return 0;
+}
+
+static void FreePreload(preload_t *preload)
+{
+    free(preload->filename);
+    free(preload->data);
+    memset(preload, 0, sizeof(preload_t));
+}
+
+static void StartPreloadThread(void)
+{
+    memset(preloads, 0, sizeof(preloads));
+
+    preload_mutex = SDL_CreateMutex();
+    preload_sem = SDL_CreateSemaphore(0);
+    SDL_AtomicSet(&preload_running, 1);
+
+    preload_thread = SDL_CreateThread(PreloadThread, "Music preload", NULL);
+
+    if (preload_thread == NULL)
+    {
+        fprintf(stderr, "Failed to start music preload thread: %s\n",
+                SDL_GetError());
+    }
+}
+
+static void StopPreloadThread(void)
+{
+    int i;
+
+    if (preload_thread != NULL)
+    {
+        SDL_AtomicSet(&preload_running, 0);
+        SDL_SemPost(preload_sem);
+        SDL_WaitThread(preload_thread, NULL);
+        preload_thread = NULL;
+    }
+
+    if (preload_mutex != NULL)
+    {
+        for (i = 0; i < MAX_PRELOADED_TRACKS; ++i)
+        {
+            FreePreload(&preloads[i]);
+        }
+
+        SDL_DestroySemaphore(preload_sem);
+        preload_sem = NULL;
+        SDL_DestroyMutex(preload_mutex);
+        preload_mutex = NULL;
+    }
+}
+
+// Find a preloaded track that has finished loading.
+
+static preload_t *FindPreload(const char *filename)
+{
+    preload_t *result = NULL;
+    int i;
+
+    if (preload_thread == NULL)
+    {
+        return NULL;
+    }
+
+    SDL_LockMutex(preload_mutex);
+
+    for (i = 0; i < MAX_PRELOADED_TRACKS; ++i)
+    {
+        if (preloads[i].state == PRELOAD_READY
+         && !strcmp(preloads[i].filename, filename))
+        {
+            result = &preloads[i];
+            result->last_used = ++preload_counter;
+            break;
+        }
+    }
+
+    SDL_UnlockMutex(preload_mutex);
+
+    return result;
+}
+
 static char *GetFullPath(const char *musicdir, const char *path)
 {
     char *result;
@@ -1108,6 +1329,7 @@ static void I_MP_ShutdownMusic(void)
     if (music_initialized)
     {
         Mix_HaltMusic();
+        StopPreloadThread();
         music_initialized = false;
 
         if (sdl_was_initialized)
@@ -1197,6 +1419,11 @@ static boolean I_MP_InitMusic(void)
     Mix_RegisterEffect(MIX_CHANNEL_POST, TrackPositionCallback, NULL, NULL);
 #endif // !USE_SDL_MIXER_LOOPING
 
+    if (music_initialized)
+    {
+        StartPreloadThread();
+    }
+
     return music_initialized;
 }
 
@@ -1288,6 +1515,7 @@ static void I_MP_StopSong(void)
 static void I_MP_UnRegisterSong(void *handle)
 {
     Mix_Music *music = (Mix_Music *) handle;
+    int i;
 
     if (!music_initialized)
     {
@@ -1300,11 +1528,21 @@ static void I_MP_UnRegisterSong(void *handle)
     }
 
     Mix_FreeMusic(music);
+
+    // The preloaded data for this song may now be evicted.
+    for (i = 0; i < MAX_PRELOADED_TRACKS; ++i)
+    {
+        if (preloads[i].music == music)
+        {
+            preloads[i].music = NULL;
+        }
+    }
 }
 
 static void *I_MP_RegisterSong(void *data, int len)
 {
     const char *filename;
+    preload_t *preload;
     Mix_Music *music;
 
     if (!music_initialized)
@@ -1319,7 +1557,22 @@ static void *I_MP_RegisterSong(void *data, int len)
         return NULL;
     }
 
-    music = Mix_LoadMUS(filename);
+    // If the track was preloaded, play it straight from memory. Only the
+    // file contents are cached; SDL_mixer still opens the decoder and
+    // parses the stream headers here.
+    preload = FindPreload(filename);
+
+    if (preload != NULL && preload->data != NULL)
+    {
+        music = Mix_LoadMUS_RW(SDL_RWFromConstMem(preload->data,
+                                                  preload->data_len),
+                               SDL_TRUE);
+    }
+    else
+    {
+        music = Mix_LoadMUS(filename);
+    }
+
     if (music == NULL)
     {
         // Fall through and play MIDI normally, but print an error
@@ -1329,14 +1582,93 @@ static void *I_MP_RegisterSong(void *data, int len)
         return NULL;
     }
 
+    if (preload != NULL && preload->data != NULL)
+    {
+        preload->music = music;
+    }
+
 #if !USE_SDL_MIXER_LOOPING
     // Read loop point metadata from the file so that we know where
     // to loop the music.
-    ReadLoopPoints(filename, &file_metadata);
+    if (preload != NULL)
+    {
+        file_metadata = preload->metadata;
+    }
+    else
+    {
+        ReadLoopPoints(filename, &file_metadata);
+    }
 #endif // !USE_SDL_MIXER_LOOPING
     return music;
 }
 
+// Queue the substitute track for a song that is likely to be played soon
+// to be loaded in the background.
+void I_MP_PrecacheSong(void *data, int len)
+{
+    const char *filename;
+    preload_t *preload = NULL;
+    int i;
+
+    if (!music_initialized || preload_thread == NULL)
+    {
+        return;
+    }
+
+    filename = GetSubstituteMusicFile(data, len);
+    if (filename == NULL || !M_FileExists(filename))
+    {
+        return;
+    }
+
+    SDL_LockMutex(preload_mutex);
+
+    for (i = 0; i < MAX_PRELOADED_TRACKS; ++i)
+    {
+        if (preloads[i].state != PRELOAD_EMPTY
+         && !strcmp(preloads[i].filename, filename))
+        {
+            // Already loaded or on its way.
+            preloads[i].last_used = ++preload_counter;
+            SDL_UnlockMutex(preload_mutex);
+            return;
+        }
+    }
+
+    // Use a free slot if there is one; otherwise evict the least recently
+    // used track that is neither still loading nor currently playing.
+
+    for (i = 0; i < MAX_PRELOADED_TRACKS; ++i)
+    {
+        if (preloads[i].state == PRELOAD_EMPTY)
+        {
+            preload = &preloads[i];
+            break;
+        }
+
+        if (preloads[i].state == PRELOAD_READY && preloads[i].music == NULL
+         && (preload == NULL || preloads[i].last_used < preload->last_used))
+        {
+            preload = &preloads[i];
+        }
+    }
+
+    if (preload != NULL)
+    {
+        FreePreload(preload);
+        preload->filename = M_StringDuplicate(filename);
+        preload->last_used = ++preload_counter;
+        preload->state = PRELOAD_QUEUED;
+    }
+
+    SDL_UnlockMutex(preload_mutex);
+
+    if (preload != NULL)
+    {
+        SDL_SemPost(preload_sem);
+    }
+}
+
 // Is the song playing?
 static boolean I_MP_MusicIsPlaying(void)
 {
@@ -1463,6 +1795,11 @@ static void *I_NULL_RegisterSong(void *data, int len)
 }
 
 
+void I_MP_PrecacheSong(void *data, int len)
+{
+}
+
+
 static void I_NULL_UnRegisterSong(void *handle)
 {
 }
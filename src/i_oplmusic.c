@@ -352,6 +352,10 @@ static unsigned int last_perc_count;
 char *snd_dmxoption = "-opl3"; // [crispy] default to OPL3 emulation
 int opl_io_port = 0x388;
 
+// If non-zero, emulated OPL output is rendered on a separate thread.
+
+int opl_render_thread = 0;
+
 // If true, OPL sound channels are reversed to their correct arrangement
 // (as intended by the MIDI standard) rather than the backwards one
 // used by DMX due to a bug.
@@ -1605,24 +1609,22 @@ static void I_OPL_UnRegisterSong(void *handle)
     }
 }
 
-static boolean ConvertMus(byte *musdata, int len, char *filename)
+static midi_file_t *ConvertMus(byte *musdata, int len)
 {
     MEMFILE *instream;
     MEMFILE *outstream;
     void *outbuf;
     size_t outbuf_len;
-    int result;
+    midi_file_t *result = NULL;
 
     instream = mem_fopen_read(musdata, len);
     outstream = mem_fopen_write();
 
-    result = mus2mid(instream, outstream);
-
-    if (result == 0)
+    if (mus2mid(instream, outstream) == 0)
     {
         mem_get_buf(outstream, &outbuf, &outbuf_len);
 
-        M_WriteFile(filename, outbuf, outbuf_len);
+        result = MIDI_LoadFileFromMem(outbuf, outbuf_len);
     }
 
     mem_fclose(instream);
@@ -1634,7 +1636,6 @@ static boolean ConvertMus(byte *musdata, int len, char *filename)
 static void *I_OPL_RegisterSong(void *data, int len)
 {
     midi_file_t *result;
-    char *filename;
 
     if (!music_initialized)
     {
@@ -1644,32 +1645,23 @@ static void *I_OPL_RegisterSong(void *data, int len)
     // MUS files begin with "MUS"
     // Reject anything which doesnt have this signature
 
-    filename = M_TempFile("doom.mid");
-
     // [crispy] remove MID file size limit
     if (IsMid(data, len) /* && len < MAXMIDLENGTH */)
     {
-        M_WriteFile(filename, data, len);
+        result = MIDI_LoadFileFromMem(data, len);
     }
     else
     {
         // Assume a MUS file and try to convert
 
-        ConvertMus(data, len, filename);
+        result = ConvertMus(data, len);
     }
 
-    result = MIDI_LoadFile(filename);
-
     if (result == NULL)
     {
         fprintf(stderr, "I_OPL_RegisterSong: Failed to load MID.\n");
     }
 
-    // remove file now
-
-    M_remove(filename);
-    free(filename);
-
     return result;
 }
 
@@ -1713,6 +1705,7 @@ static boolean I_OPL_InitMusic(void)
     opl_init_result_t chip_type;
 
     OPL_SetSampleRate(snd_samplerate);
+    OPL_SetRenderThread(opl_render_thread);
 
     chip_type = OPL_Init(opl_io_port);
     if (chip_type == OPL_INIT_NONE)
@@ -0,0 +1,282 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      [crispy] Frame pacing for the uncapped frame rate limiter.
+//
+//      Waiting for the next frame is split into a sleep and a short
+//      spin.  The sleep stops early by the amount the system has been
+//      seen to oversleep, so the spin that makes up the difference
+//      stays in the tens of microseconds instead of a millisecond.
+//      With vsync, the present time of each frame is used to predict
+//      the following vblanks, so that a limited frame rate lines up
+//      with the display instead of beating against it.
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+#include "crispy.h"
+#include "doomtype.h"
+#include "i_pacer.h"
+#include "i_system.h"
+#include "i_timer.h"
+#include "m_argv.h"
+#include "m_misc.h"
+
+// Limits for the estimate of how much a sleep overshoots.
+
+#define MIN_OVERSLEEP_US 50
+#define MAX_OVERSLEEP_US 2000
+
+static uint64_t frame_start;
+static uint64_t last_present;
+static uint64_t oversleep_us = 1000;
+
+// Length of a display refresh, from the display mode if known and
+// otherwise measured from the present times with vsync.
+
+static uint64_t refresh_us;
+static boolean refresh_known;
+
+static unsigned int histogram[PACER_NUM_BUCKETS];
+
+static const char *csv_filename;
+
+static pacer_callback_t wait_callback;
+
+static void WriteCSV(void)
+{
+    FILE *f;
+    int i;
+
+    f = M_fopen(csv_filename, "w");
+
+    if (f == NULL)
+    {
+        fprintf(stderr, "I_PacerWriteCSV: Failed to open %s\n", csv_filename);
+        return;
+    }
+
+    fprintf(f, "min_us,max_us,frames\n");
+
+    for (i = 0; i < PACER_NUM_BUCKETS; ++i)
+    {
+        fprintf(f, "%d,%d,%u\n", i * PACER_BUCKET_US,
+                i < PACER_NUM_BUCKETS - 1 ? (i + 1) * PACER_BUCKET_US : -1,
+                histogram[i]);
+    }
+
+    fclose(f);
+}
+
+void I_InitPacer(void)
+{
+    int p;
+
+#ifdef __linux__
+    // Timer slack lets the kernel delay our wakeups to batch them with
+    // others; 50us by default.  Ask for as little as it will give.
+
+    prctl(PR_SET_TIMERSLACK, 1, 0, 0, 0);
+#endif
+
+    //!
+    // @category video
+    // @arg <file>
+    //
+    // Write a histogram of frame times to the given CSV file on exit.
+    //
+
+    p = M_CheckParmWithArgs("-framecsv", 1);
+
+    if (p > 0)
+    {
+        csv_filename = myargv[p + 1];
+        I_AtExit(WriteCSV, true);
+    }
+}
+
+void I_PacerSetRefreshRate(int hz)
+{
+    refresh_known = hz > 0;
+
+    if (refresh_known)
+    {
+        refresh_us = 1000000 / hz;
+    }
+}
+
+void I_PacerPresented(boolean vsync)
+{
+    uint64_t now, interval;
+    int bucket;
+
+    now = I_GetTimeUS();
+    interval = now - last_present;
+
+    if (last_present != 0)
+    {
+        bucket = interval / PACER_BUCKET_US;
+
+        if (bucket >= PACER_NUM_BUCKETS)
+        {
+            bucket = PACER_NUM_BUCKETS - 1;
+        }
+
+        ++histogram[bucket];
+
+        // Without a refresh rate from the display mode, take the
+        // shortest intervals between vsynced presents as the refresh.
+
+        if (vsync && !refresh_known && interval > 0)
+        {
+            if (refresh_us == 0 || interval < refresh_us)
+            {
+                refresh_us = interval;
+            }
+            else if (interval < refresh_us + refresh_us / 4)
+            {
+                refresh_us += ((int64_t) interval - (int64_t) refresh_us) / 8;
+            }
+        }
+    }
+
+    last_present = now;
+}
+
+// Sleep until shortly before the deadline, then spin the rest.
+
+static void WaitUntil(uint64_t deadline)
+{
+    uint64_t now, requested, slept;
+    uint64_t next_callback;
+
+    now = I_GetTimeUS();
+
+    // Long waits are broken up at the times the callback asks for, so
+    // that a low frame rate does not hold up reading input.
+
+    while (wait_callback != NULL && now < deadline)
+    {
+        next_callback = now + wait_callback();
+
+        if (next_callback + oversleep_us >= deadline)
+        {
+            break;
+        }
+
+        I_SleepUS(next_callback - now);
+        now = I_GetTimeUS();
+    }
+
+    if (now >= deadline)
+    {
+        return;
+    }
+
+    if (deadline - now > oversleep_us)
+    {
+        requested = deadline - now - oversleep_us;
+        I_SleepUS(requested);
+        slept = I_GetTimeUS() - now;
+
+        // Adapt quickly when sleeps overshoot more than we expected,
+        // and slowly when they get better.
+
+        if (slept > requested + oversleep_us)
+        {
+            oversleep_us = slept - requested;
+        }
+        else if (slept > requested)
+        {
+            oversleep_us -= (oversleep_us - (slept - requested)) / 16;
+        }
+
+        oversleep_us = BETWEEN(MIN_OVERSLEEP_US, MAX_OVERSLEEP_US,
+                               oversleep_us);
+    }
+
+    while (I_GetTimeUS() < deadline);
+}
+
+void I_PacerWait(int fpslimit, boolean vsync)
+{
+    uint64_t target, ideal, deadline;
+    uint64_t vblanks;
+
+    // Frames are paced against an ideal timeline, so that rounding to
+    // vblanks does not add up over time.
+
+    target = 1000000ull / fpslimit;
+    ideal = frame_start + target;
+    deadline = ideal;
+
+    if (vsync && refresh_us > 0 && last_present != 0)
+    {
+        // Presenting already blocks until the next vblank, so there is
+        // nothing to add if the limit is at or above the refresh rate.
+
+        if (target <= refresh_us)
+        {
+            frame_start = I_GetTimeUS();
+            return;
+        }
+
+        // Otherwise wake up half a refresh before the vblank nearest
+        // the ideal time, so that the frame is shown on that vblank.
+
+        vblanks = (ideal + refresh_us / 2 - last_present) / refresh_us;
+
+        if (vblanks < 1)
+        {
+            vblanks = 1;
+        }
+
+        deadline = last_present + vblanks * refresh_us - refresh_us / 2;
+    }
+
+    WaitUntil(deadline);
+
+    // If we fell far behind, start counting again from now rather than
+    // trying to catch up.
+
+    frame_start = ideal;
+
+    if (I_GetTimeUS() > ideal + target)
+    {
+        frame_start = I_GetTimeUS();
+    }
+}
+
+void I_PacerSetCallback(pacer_callback_t callback)
+{
+    wait_callback = callback;
+}
+
+void I_PacerPoll(void)
+{
+    if (wait_callback != NULL)
+    {
+        wait_callback();
+    }
+}
+
+const unsigned int *I_PacerHistogram(void)
+{
+    return histogram;
+}
@@ -0,0 +1,54 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      [crispy] Frame pacing for the uncapped frame rate limiter.
+//
+
+#ifndef __I_PACER__
+#define __I_PACER__
+
+#include "doomtype.h"
+
+// Frame times are counted in a histogram of 250us buckets; the last
+// bucket also counts all slower frames.
+
+#define PACER_BUCKET_US 250
+#define PACER_NUM_BUCKETS 128
+
+void I_InitPacer(void);
+
+// Display refresh rate in Hz, or 0 if unknown.
+void I_PacerSetRefreshRate(int hz);
+
+// Call right after presenting a frame.
+void I_PacerPresented(boolean vsync);
+
+// Wait until it is time to start the next frame.
+void I_PacerWait(int fpslimit, boolean vsync);
+
+// Function to call while waiting, so that input keeps being read as
+// tics become due.  Returns the number of us until it wants to be
+// called again.
+typedef uint64_t (*pacer_callback_t)(void);
+
+void I_PacerSetCallback(pacer_callback_t callback);
+
+// Call the function above from the slow parts of presenting a frame,
+// so that slow frames do not hold up reading input either.
+void I_PacerPoll(void);
+
+// Frame time histogram, PACER_NUM_BUCKETS entries.
+const unsigned int *I_PacerHistogram(void);
+
+#endif
@@ -0,0 +1,164 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      [crispy] Running independent pieces of work on worker threads.
+//
+//      A small pool of threads is started on first use.  Each call
+//      splits the items into one range per thread, and the calling
+//      thread processes the last range itself.
+//
+
+#include "SDL.h"
+
+#include "doomtype.h"
+#include "i_parallel.h"
+#include "i_system.h"
+
+#define MAX_WORKERS 7
+
+typedef struct
+{
+    SDL_Thread *thread;
+    SDL_sem *start;
+    SDL_sem *done;
+
+    // Range of items to process, set before each start.
+
+    int start_item;
+    int end_item;
+} parallel_worker_t;
+
+static parallel_worker_t workers[MAX_WORKERS];
+static int num_workers;
+static boolean workers_quit;
+static boolean initialized = false;
+
+static parallel_func_t parallel_func;
+static void *parallel_data;
+
+static int ParallelWorker(void *arg)
+{
+    parallel_worker_t *worker = arg;
+
+    for (;;)
+    {
+        SDL_SemWait(worker->start);
+
+        if (workers_quit)
+        {
+            break;
+        }
+
+        parallel_func(parallel_data, worker->start_item, worker->end_item);
+        SDL_SemPost(worker->done);
+    }
+
+    return 0;
+}
+
+static void I_ShutdownParallel(void)
+{
+    int i;
+
+    workers_quit = true;
+
+    for (i = 0; i < num_workers; ++i)
+    {
+        SDL_SemPost(workers[i].start);
+        SDL_WaitThread(workers[i].thread, NULL);
+        SDL_DestroySemaphore(workers[i].start);
+        SDL_DestroySemaphore(workers[i].done);
+    }
+
+    num_workers = 0;
+}
+
+void I_InitParallel(void)
+{
+    int i, cpus;
+
+    if (initialized)
+    {
+        return;
+    }
+
+    initialized = true;
+
+    // Leave one CPU for the calling thread, which takes a range itself.
+
+    cpus = SDL_GetCPUCount() - 1;
+
+    if (cpus > MAX_WORKERS)
+    {
+        cpus = MAX_WORKERS;
+    }
+
+    for (i = 0; i < cpus; ++i)
+    {
+        parallel_worker_t *worker = &workers[num_workers];
+
+        worker->start = SDL_CreateSemaphore(0);
+        worker->done = SDL_CreateSemaphore(0);
+        worker->thread = SDL_CreateThread(ParallelWorker, "Parallel",
+                                          worker);
+
+        if (worker->thread == NULL)
+        {
+            SDL_DestroySemaphore(worker->start);
+            SDL_DestroySemaphore(worker->done);
+            break;
+        }
+
+        ++num_workers;
+    }
+
+    I_AtExit(I_ShutdownParallel, true);
+}
+
+void I_ParallelFor(parallel_func_t func, void *data, int count)
+{
+    int ranges, range_items, item;
+    int i;
+
+    I_InitParallel();
+
+    parallel_func = func;
+    parallel_data = data;
+
+    ranges = num_workers + 1;
+    range_items = (count + ranges - 1) / ranges;
+    item = 0;
+
+    // Hand out the first ranges to the workers, and process the last
+    // one here while they run.
+
+    for (i = 0; i < ranges - 1 && item < count; ++i)
+    {
+        workers[i].start_item = item;
+        workers[i].end_item = range_items < count - item ? item + range_items
+                                                         : count;
+        item = workers[i].end_item;
+
+        SDL_SemPost(workers[i].start);
+    }
+
+    ranges = i;
+
+    func(data, item, count);
+
+    for (i = 0; i < ranges; ++i)
+    {
+        SDL_SemWait(workers[i].done);
+    }
+}
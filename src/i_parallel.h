@@ -0,0 +1,33 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      [crispy] Running independent pieces of work on worker threads.
+//
+
+#ifndef __I_PARALLEL__
+#define __I_PARALLEL__
+
+#include "doomtype.h"
+
+// Called with a range [start, end) of the items to process.
+typedef void (*parallel_func_t)(void *data, int start, int end);
+
+void I_InitParallel(void);
+
+// Split items 0 to count-1 into ranges and process them on the worker
+// threads and the calling thread.  Returns when all are done.  There is
+// one pool for the whole program, so only call this from the main thread.
+void I_ParallelFor(parallel_func_t func, void *data, int count);
+
+#endif
@@ -319,6 +319,12 @@ static void I_SDL_StopSong(void)
     Mix_HaltMusic();
 }
 
+// MIDI data converted from MUS for the currently registered song. SDL_mixer
+// may keep reading from its RWops until the song is freed, so the buffer
+// has to outlive Mix_LoadMUS_RW().
+
+static MEMFILE *converted_song = NULL;
+
 static void I_SDL_UnRegisterSong(void *handle)
 {
     Mix_Music *music = (Mix_Music *) handle;
@@ -332,38 +338,40 @@ static void I_SDL_UnRegisterSong(void *handle)
     {
         Mix_FreeMusic(music);
     }
+
+    if (converted_song != NULL)
+    {
+        mem_fclose(converted_song);
+        converted_song = NULL;
+    }
 }
 
-static boolean ConvertMus(byte *musdata, int len, const char *filename)
+static MEMFILE *ConvertMus(byte *musdata, int len)
 {
     MEMFILE *instream;
     MEMFILE *outstream;
-    void *outbuf;
-    size_t outbuf_len;
-    int result;
 
     instream = mem_fopen_read(musdata, len);
     outstream = mem_fopen_write();
 
-    result = mus2mid(instream, outstream);
-
-    if (result == 0)
+    if (mus2mid(instream, outstream) != 0)
     {
-        mem_get_buf(outstream, &outbuf, &outbuf_len);
-
-        M_WriteFile(filename, outbuf, outbuf_len);
+        mem_fclose(outstream);
+        outstream = NULL;
     }
 
     mem_fclose(instream);
-    mem_fclose(outstream);
 
-    return result;
+    return outstream;
 }
 
 static void *I_SDL_RegisterSong(void *data, int len)
 {
     char *filename;
     Mix_Music *music;
+    MEMFILE *midi = NULL;
+    void *buf = data;
+    size_t buflen = len;
 
     if (!music_initialized)
     {
@@ -373,28 +381,60 @@ static void *I_SDL_RegisterSong(void *data, int len)
     // MUS files begin with "MUS"
     // Reject anything which doesnt have this signature
 
-    filename = M_TempFile("doom"); // [crispy] generic filename
-
     // [crispy] Reverse Choco's logic from "if (MIDI)" to "if (not MUS)"
     // MUS is the only format that requires conversion,
     // let SDL_Mixer figure out the others
 /*
     if (IsMid(data, len) && len < MAXMIDLENGTH)
 */
-    if (!IsMus(data, len)) // [crispy] MUS_HEADER_MAGIC
+    if (IsMus(data, len)) // [crispy] MUS_HEADER_MAGIC
     {
-        M_WriteFile(filename, data, len);
+	// Assume a MUS file and try to convert
+
+        midi = ConvertMus(data, len);
+
+        if (midi == NULL)
+        {
+            fprintf(stderr, "Error converting MUS to MIDI.\n");
+            return NULL;
+        }
+
+        mem_get_buf(midi, &buf, &buflen);
     }
-    else
+
+    if (strlen(snd_musiccmd) == 0)
     {
-	// Assume a MUS file and try to convert
+        // Load straight from memory. The lump data stays cached until
+        // the song is unregistered, and so does our converted copy.
+
+        if (converted_song != NULL)
+        {
+            mem_fclose(converted_song);
+        }
+
+        converted_song = midi;
 
-        ConvertMus(data, len, filename);
+        music = Mix_LoadMUS_RW(SDL_RWFromConstMem(buf, buflen), SDL_TRUE);
+        if (music == NULL)
+        {
+            // Failed to load
+            fprintf(stderr, "Error loading midi: %s\n", Mix_GetError());
+        }
+
+        return music;
     }
 
-    // Load the MIDI. In an ideal world we'd be using Mix_LoadMUS_RW()
-    // by now, but Mix_SetMusicCMD() only works with Mix_LoadMUS(), so
-    // we have to generate a temporary file.
+    // Mix_SetMusicCMD() only works with Mix_LoadMUS(), so an external
+    // MIDI program still needs a temporary file.
+
+    filename = M_TempFile("doom"); // [crispy] generic filename
+
+    M_WriteFile(filename, buf, buflen);
+
+    if (midi != NULL)
+    {
+        mem_fclose(midi);
+    }
 
     music = Mix_LoadMUS(filename);
     if (music == NULL)
@@ -403,15 +443,8 @@ static void *I_SDL_RegisterSong(void *data, int len)
         fprintf(stderr, "Error loading midi: %s\n", Mix_GetError());
     }
 
-    // Remove the temporary MIDI file; however, when using an external
-    // MIDI program we can't delete the file. Otherwise, the program
-    // won't find the file to play. This means we leave a mess on
-    // disk :(
-
-    if (strlen(snd_musiccmd) == 0)
-    {
-        M_remove(filename);
-    }
+    // We can't delete the file: otherwise the external program won't find
+    // the file to play. This means we leave a mess on disk :(
 
     free(filename);
 
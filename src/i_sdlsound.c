@@ -55,6 +55,11 @@ int use_libsamplerate = 1;
 
 float libsamplerate_scale = 0.65f;
 
+// [crispy] If non-zero, positional parameters are applied by a spatial
+// stage in the mixer thread rather than by Mix_SetPanning() once per tic.
+
+int snd_spatial = 0;
+
 
 #ifndef DISABLE_SDL2MIXER
 
@@ -945,6 +950,156 @@ static int I_SDL_GetSfxLumpNum(sfxinfo_t *sfx)
     return W_CheckNumForName(namebuf);
 }
 
+// [crispy] Spatial mixer stage.
+//
+// The game only updates sound parameters once per tic, which makes moving
+// sources step audibly between pan positions. With snd_spatial enabled the
+// game thread just publishes the target gains for each channel, and an
+// effect running in the mixer thread ramps towards them across every
+// buffer. The ear facing away from the source additionally hears it up to
+// SPATIAL_MAX_ITD_US later (interaural time difference), on top of the
+// level difference already given by the stereo separation.
+
+#define SPATIAL_MAX_ITD_US 660
+#define SPATIAL_HISTORY 256 // must be a power of two
+
+typedef struct
+{
+    SDL_atomic_t target;       // packed left gain, right gain, separation
+    SDL_atomic_t start_count;  // bumped whenever a new sound starts
+    int seen_count;
+    int gain_l, gain_r;        // 8.23 fixed point
+    int delay_l, delay_r;      // 16.16 fixed point, in samples
+    Sint16 history[SPATIAL_HISTORY];
+    unsigned int history_pos;
+} spatial_channel_t;
+
+static spatial_channel_t spatial_channels[NUM_CHANNELS];
+static boolean spatial_active = false;
+static int spatial_max_delay;
+
+#define SPATIAL_PACK(left, right, sep) ((left) | ((right) << 8) | ((sep) << 16))
+
+static void SpatialTargets(int packed, int *gain_l, int *gain_r,
+                           int *delay_l, int *delay_r)
+{
+    int left = packed & 0xff;
+    int right = (packed >> 8) & 0xff;
+    int offset = ((packed >> 16) & 0xff) - 128;
+
+    *gain_l = (left << 23) / 255;
+    *gain_r = (right << 23) / 255;
+
+    // Sounds on the right reach the left ear late, and vice versa.
+
+    *delay_l = offset > 0 ? (offset * spatial_max_delay) / 127 : 0;
+    *delay_r = offset < 0 ? (-offset * spatial_max_delay) / 128 : 0;
+}
+
+// Read the history delayed by the given 16.16 number of samples,
+// interpolating linearly between neighbouring samples.
+
+static int SpatialDelayed(spatial_channel_t *sc, int delay)
+{
+    unsigned int pos = sc->history_pos - (delay >> 16);
+    int frac = (delay >> 8) & 0xff;
+    int a = sc->history[pos & (SPATIAL_HISTORY - 1)];
+    int b = sc->history[(pos - 1) & (SPATIAL_HISTORY - 1)];
+
+    return (a * (256 - frac) + b * frac) / 256;
+}
+
+static void SpatialEffect(int chan, void *stream, int len, void *udata)
+{
+    spatial_channel_t *sc = udata;
+    Sint16 *samples = stream;
+    int frames = len / 4;
+    int gain_l, gain_r, delay_l, delay_r;
+    int step_gl, step_gr, step_dl, step_dr;
+    int count;
+    int i;
+
+    if (frames <= 0)
+    {
+        return;
+    }
+
+    SpatialTargets(SDL_AtomicGet(&sc->target),
+                   &gain_l, &gain_r, &delay_l, &delay_r);
+
+    // A new sound started on this channel: jump straight to its
+    // parameters instead of ramping from those of the previous one.
+
+    count = SDL_AtomicGet(&sc->start_count);
+
+    if (count != sc->seen_count)
+    {
+        sc->seen_count = count;
+        sc->gain_l = gain_l;
+        sc->gain_r = gain_r;
+        sc->delay_l = delay_l;
+        sc->delay_r = delay_r;
+        memset(sc->history, 0, sizeof(sc->history));
+    }
+
+    step_gl = (gain_l - sc->gain_l) / frames;
+    step_gr = (gain_r - sc->gain_r) / frames;
+    step_dl = (delay_l - sc->delay_l) / frames;
+    step_dr = (delay_r - sc->delay_r) / frames;
+
+    for (i = 0; i < frames; ++i)
+    {
+        sc->history_pos = (sc->history_pos + 1) & (SPATIAL_HISTORY - 1);
+        sc->history[sc->history_pos] =
+            (samples[2 * i] + samples[2 * i + 1]) / 2;
+
+        sc->gain_l += step_gl;
+        sc->gain_r += step_gr;
+        sc->delay_l += step_dl;
+        sc->delay_r += step_dr;
+
+        samples[2 * i] =
+            (SpatialDelayed(sc, sc->delay_l) * (sc->gain_l >> 8)) >> 15;
+        samples[2 * i + 1] =
+            (SpatialDelayed(sc, sc->delay_r) * (sc->gain_r >> 8)) >> 15;
+    }
+
+    // Land exactly on the target, whatever the rounding of the steps.
+
+    sc->gain_l = gain_l;
+    sc->gain_r = gain_r;
+    sc->delay_l = delay_l;
+    sc->delay_r = delay_r;
+}
+
+static void InitSpatial(void)
+{
+    spatial_active = false;
+
+    if (!snd_spatial)
+    {
+        return;
+    }
+
+    if (mixer_format != AUDIO_S16SYS || mixer_channels != 2)
+    {
+        fprintf(stderr, "I_SDL_InitSound: snd_spatial requires 16-bit "
+                        "stereo output, disabling.\n");
+        return;
+    }
+
+    spatial_max_delay = (int) (mixer_freq * (SPATIAL_MAX_ITD_US / 1000000.0)
+                               * 65536.0);
+
+    if (spatial_max_delay > (SPATIAL_HISTORY - 2) << 16)
+    {
+        spatial_max_delay = (SPATIAL_HISTORY - 2) << 16;
+    }
+
+    memset(spatial_channels, 0, sizeof(spatial_channels));
+    spatial_active = true;
+}
+
 static void I_SDL_UpdateSoundParams(int handle, int vol, int sep)
 {
     int left, right;
@@ -962,6 +1117,17 @@ static void I_SDL_UpdateSoundParams(int handle, int vol, int sep)
     if (right < 0) right = 0;
     else if (right > 255) right = 255;
 
+    // [crispy] hand the new target over to the mixer thread
+    if (spatial_active)
+    {
+        if (sep < 0) sep = 0;
+        else if (sep > 255) sep = 255;
+
+        SDL_AtomicSet(&spatial_channels[handle].target,
+                      SPATIAL_PACK(left, right, sep));
+        return;
+    }
+
     Mix_SetPanning(handle, left, right);
 }
 
@@ -1031,6 +1197,22 @@ static int I_SDL_StartSound(sfxinfo_t *sfxinfo, int channel, int vol, int sep, i
 
     // play sound
 
+    if (spatial_active)
+    {
+        // [crispy] publish the initial parameters before the channel
+        // starts; the effect is removed again whenever it stops.
+        I_SDL_UpdateSoundParams(channel, vol, sep);
+        SDL_AtomicAdd(&spatial_channels[channel].start_count, 1);
+
+        Mix_PlayChannel(channel, &snd->chunk, 0);
+        Mix_RegisterEffect(channel, SpatialEffect, NULL,
+                           &spatial_channels[channel]);
+
+        channels_playing[channel] = snd;
+
+        return channel;
+    }
+
     Mix_PlayChannel(channel, &snd->chunk, 0);
 
     channels_playing[channel] = snd;
@@ -1156,6 +1338,8 @@ static boolean I_SDL_InitSound(boolean _use_sfx_prefix)
 
     Mix_QuerySpec(&mixer_freq, &mixer_format, &mixer_channels);
 
+    InitSpatial();
+
 #ifdef HAVE_LIBSAMPLERATE
     if (use_libsamplerate != 0)
     {
@@ -506,6 +506,25 @@ void *I_RegisterSong(void *data, int len)
     }
 }
 
+// Hint that a song is likely to be played soon, so that a substitute
+// track from a music pack can be loaded ahead of time.
+
+void I_PrecacheSong(void *data, int len)
+{
+    if (music_packs_active)
+    {
+        I_MP_PrecacheSong(data, len);
+    }
+}
+
+// Returns true if songs may be substituted by music pack tracks, which
+// is the only case in which I_PrecacheSong() does anything.
+
+boolean I_MusicPacksActive(void)
+{
+    return music_packs_active;
+}
+
 void I_UnRegisterSong(void *handle)
 {
     if (active_music_module != NULL)
@@ -556,7 +575,9 @@ void I_BindSoundVariables(void)
     M_BindIntVariable("snd_samplerate",          &snd_samplerate);
     M_BindIntVariable("snd_cachesize",           &snd_cachesize);
     M_BindIntVariable("opl_io_port",             &opl_io_port);
+    M_BindIntVariable("opl_render_thread",       &opl_render_thread);
     M_BindIntVariable("snd_pitchshift",          &snd_pitchshift);
+    M_BindIntVariable("snd_spatial",             &snd_spatial);
 
     M_BindStringVariable("music_pack_path",      &music_pack_path);
     M_BindStringVariable("timidity_cfg_path",    &timidity_cfg_path);
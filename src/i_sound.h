@@ -223,6 +223,8 @@ void I_SetMusicVolume(int volume);
 void I_PauseSong(void);
 void I_ResumeSong(void);
 void *I_RegisterSong(void *data, int len);
+void I_PrecacheSong(void *data, int len);
+boolean I_MusicPacksActive(void);
 void I_UnRegisterSong(void *handle);
 void I_PlaySong(void *handle, boolean looping);
 void I_StopSong(void);
@@ -240,6 +242,7 @@ extern char *snd_musiccmd;
 extern int snd_pitchshift;
 extern char *snd_dmxoption;
 extern int use_libsamplerate;
+extern int snd_spatial;
 extern float libsamplerate_scale;
 
 void I_BindSoundVariables(void);
@@ -268,10 +271,15 @@ extern const music_module_t music_fl_module;
 // For OPL module:
 
 extern int opl_io_port;
+extern int opl_render_thread;
 
-// For native music module:
+// For music pack module:
 
 extern char *music_pack_path;
+void I_MP_PrecacheSong(void *data, int len);
+
+// For native music module:
+
 extern char *timidity_cfg_path;
 #ifdef _WIN32
 extern char *winmm_midi_device;
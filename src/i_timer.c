@@ -16,6 +16,13 @@
 //      Timer functions.
 //
 
+#include "config.h"
+
+#ifdef HAVE_CLOCK_NANOSLEEP
+#include <errno.h>
+#include <time.h>
+#endif
+
 #include "SDL.h"
 
 #include "i_timer.h"
@@ -82,6 +89,23 @@ void I_Sleep(int ms)
     SDL_Delay(ms);
 }
 
+// [crispy] Sleep for a specified number of us.  SDL_Delay() only has
+// millisecond resolution, so use clock_nanosleep() where we have it.
+
+void I_SleepUS(uint64_t us)
+{
+#ifdef HAVE_CLOCK_NANOSLEEP
+    struct timespec ts;
+
+    ts.tv_sec = us / 1000000;
+    ts.tv_nsec = (us % 1000000) * 1000;
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, 0, &ts, &ts) == EINTR);
+#else
+    SDL_Delay(us / 1000);
+#endif
+}
+
 void I_WaitVBL(int count)
 {
     I_Sleep((count * 1000) / 70);
@@ -37,6 +37,9 @@ uint64_t I_GetTimeUS(void); // [crispy]
 // Pause for a specified number of ms
 void I_Sleep(int ms);
 
+// Pause for a specified number of us
+void I_SleepUS(uint64_t us); // [crispy]
+
 // Initialize timer
 void I_InitTimer(void);
 
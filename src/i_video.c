@@ -36,8 +36,10 @@
 #include "d_loop.h"
 #include "deh_str.h"
 #include "doomtype.h"
+#include "i_expand.h"
 #include "i_input.h"
 #include "i_joystick.h"
+#include "i_pacer.h"
 #include "i_system.h"
 #include "i_timer.h"
 #include "i_video.h"
@@ -102,6 +104,10 @@ static const uint8_t blend_alpha = 0xa8;
 extern pixel_t* colormaps; // [crispy] evil hack to get FPS dots working as in Vanilla
 #else
 static SDL_Color palette[256];
+// [crispy] palette mapped to the texture's pixel format
+static uint32_t palette_lut[256];
+// [crispy] screenbuffer's SDL palette is only needed for blitting
+static boolean sdl_palette_stale;
 #endif
 static boolean palette_to_set;
 
@@ -199,6 +205,10 @@ boolean screenvisible = true;
 
 static boolean display_fps_dots;
 
+// [crispy] Show a histogram of frame times.
+
+static boolean display_frame_histogram;
+
 // If this is true, the screen is rendered but not blitted to the
 // video buffer.
 
@@ -768,6 +778,84 @@ static void CreateUpscaledTexture(boolean force)
 //      range of [0.0, 1.0).  Used for interpolation.
 fixed_t fractionaltic;
 
+// [crispy] Draw the frame time histogram in the bottom left corner,
+// scaled to the most common frame time.
+
+#define HISTOGRAM_HEIGHT 32
+
+static void DrawFrameHistogram(void)
+{
+    const unsigned int *histogram = I_PacerHistogram();
+    unsigned int max_count = 1;
+    int x, y, height;
+
+    for (x = 0; x < PACER_NUM_BUCKETS; ++x)
+    {
+        if (histogram[x] > max_count)
+            max_count = histogram[x];
+    }
+
+    for (x = 0; x < PACER_NUM_BUCKETS && x < SCREENWIDTH; ++x)
+    {
+        height = (histogram[x] * HISTOGRAM_HEIGHT + max_count - 1) / max_count;
+
+        for (y = 0; y < height; ++y)
+        {
+#ifndef CRISPY_TRUECOLOR
+            I_VideoBuffer[(SCREENHEIGHT - 3 - y) * SCREENWIDTH + x] = 0xff;
+#else
+            I_VideoBuffer[(SCREENHEIGHT - 3 - y) * SCREENWIDTH + x] = colormaps[0xff];
+#endif
+        }
+    }
+}
+
+// [crispy] Write the screen buffer straight into the memory of the
+// streaming texture: for the 8-bit buffer, expand the palette while
+// doing so (see i_expand.c).  This saves blitting into argbbuffer and
+// then having SDL_UpdateTexture() copy that again.
+
+static void UpdateScreenTexture(void)
+{
+    void *pixels;
+    int pitch;
+#ifdef CRISPY_TRUECOLOR
+    int y;
+#endif
+
+    if (argbbuffer->format->BytesPerPixel != 4
+     || SDL_LockTexture(texture, NULL, &pixels, &pitch) != 0)
+    {
+        // Blit from the paletted 8-bit screen buffer to the intermediate
+        // 32-bit RGBA buffer that we can load into the texture.
+#ifndef CRISPY_TRUECOLOR
+        if (sdl_palette_stale)
+        {
+            SDL_SetPaletteColors(screenbuffer->format->palette, palette, 0, 256);
+            sdl_palette_stale = false;
+        }
+
+        SDL_LowerBlit(screenbuffer, &blit_rect, argbbuffer, &blit_rect);
+#endif
+        SDL_UpdateTexture(texture, NULL, argbbuffer->pixels, argbbuffer->pitch);
+        return;
+    }
+
+#ifndef CRISPY_TRUECOLOR
+    I_ExpandIndexed(screenbuffer->pixels, screenbuffer->pitch, pixels, pitch,
+                    SCREENWIDTH, SCREENHEIGHT, palette_lut);
+#else
+    for (y = 0; y < SCREENHEIGHT; ++y)
+    {
+        memcpy((byte *) pixels + y * pitch,
+               (byte *) argbbuffer->pixels + y * argbbuffer->pitch,
+               SCREENWIDTH * sizeof(pixel_t));
+    }
+#endif
+
+    SDL_UnlockTexture(texture);
+}
+
 //
 // I_FinishUpdate
 //
@@ -864,15 +952,28 @@ void I_FinishUpdate (void)
 		}
 	}
 
+    // [crispy] Frame time histogram, one column per bucket.
+
+    if (display_frame_histogram)
+    {
+	DrawFrameHistogram();
+    }
+
     // Draw disk icon before blit, if necessary.
     V_DrawDiskIcon();
 
 #ifndef CRISPY_TRUECOLOR
     if (palette_to_set)
     {
-        SDL_SetPaletteColors(screenbuffer->format->palette, palette, 0, 256);
+        sdl_palette_stale = true;
         palette_to_set = false;
 
+        for (i = 0; i < 256; ++i)
+        {
+            palette_lut[i] = SDL_MapRGB(argbbuffer->format, palette[i].r,
+                                        palette[i].g, palette[i].b);
+        }
+
         if (vga_porch_flash)
         {
             // "flash" the pillars/letterboxes with palette changes, emulating
@@ -881,16 +982,11 @@ void I_FinishUpdate (void)
                 palette[0].b, SDL_ALPHA_OPAQUE);
         }
     }
-
-    // Blit from the paletted 8-bit screen buffer to the intermediate
-    // 32-bit RGBA buffer that we can load into the texture.
-
-    SDL_LowerBlit(screenbuffer, &blit_rect, argbbuffer, &blit_rect);
 #endif
 
-    // Update the intermediate texture with the contents of the RGBA buffer.
+    // Update the intermediate texture with the contents of the screen buffer.
 
-    SDL_UpdateTexture(texture, NULL, argbbuffer->pixels, argbbuffer->pitch);
+    UpdateScreenTexture();
 
     // Make sure the pillarboxes are kept clear each frame.
 
@@ -923,37 +1019,25 @@ void I_FinishUpdate (void)
     }
 #endif
 
+    // [crispy] Uploading and scaling may have taken a while, and the
+    // present may block until the next vertical refresh; build any tics
+    // that have become due on either side of it.
+
+    I_PacerPoll();
+
     // Draw!
 
     SDL_RenderPresent(renderer);
 
+    I_PacerPresented(crispy->vsync);
+    I_PacerPoll();
+
     if (crispy->uncapped && !singletics)
     {
         // Limit framerate
         if (crispy->fpslimit >= TICRATE)
         {
-            uint64_t target_time = 1000000ull / crispy->fpslimit;
-            static uint64_t start_time;
-
-            while (1)
-            {
-                uint64_t current_time = I_GetTimeUS();
-                uint64_t elapsed_time = current_time - start_time;
-                uint64_t remaining_time = 0;
-
-                if (elapsed_time >= target_time)
-                {
-                    start_time = current_time;
-                    break;
-                }
-
-                remaining_time = target_time - elapsed_time;
-
-                if (remaining_time > 1000)
-                {
-                    I_Sleep((remaining_time - 1000) / 1000);
-                }
-            }
+            I_PacerWait(crispy->fpslimit, crispy->vsync);
         }
 
         // [AM] Figure out how far into the current tic we're in as a fixed_t.
@@ -1173,6 +1257,14 @@ void I_GraphicsCheckCommandLine(void)
 
     nograbmouse_override = M_ParmExists("-nograbmouse");
 
+    //!
+    // @category video
+    //
+    // Show a histogram of frame times at the bottom of the screen.
+    //
+
+    display_frame_histogram = M_ParmExists("-framehist");
+
     // default to fullscreen mode, allow override with command line
     // nofullscreen because we love prboom
 
@@ -1495,6 +1587,8 @@ static void SetVideoMode(void)
         video_display, SDL_GetError());
     }
 
+    I_PacerSetRefreshRate(mode.refresh_rate); // [crispy]
+
     // Turn on vsync if we aren't in a -timedemo
     if (!singletics && mode.refresh_rate > 0)
     {
@@ -1753,6 +1847,9 @@ void I_InitGraphics(void)
         I_Error("Failed to initialize video: %s", SDL_GetError());
     }
 
+    I_InitPacer(); // [crispy]
+    I_InitExpand(); // [crispy]
+
 #ifdef __WIIU__
     // For I_Error
     extern boolean sdlStarted;
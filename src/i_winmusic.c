@@ -1325,24 +1325,22 @@ static void I_WIN_ResumeSong(void)
     }
 }
 
-static boolean ConvertMus(byte *musdata, int len, const char *filename)
+static midi_file_t *ConvertMus(byte *musdata, int len)
 {
     MEMFILE *instream;
     MEMFILE *outstream;
     void *outbuf;
     size_t outbuf_len;
-    int result;
+    midi_file_t *result = NULL;
 
     instream = mem_fopen_read(musdata, len);
     outstream = mem_fopen_write();
 
-    result = mus2mid(instream, outstream);
-
-    if (result == 0)
+    if (mus2mid(instream, outstream) == 0)
     {
         mem_get_buf(outstream, &outbuf, &outbuf_len);
 
-        M_WriteFile(filename, outbuf, outbuf_len);
+        result = MIDI_LoadFileFromMem(outbuf, outbuf_len);
     }
 
     mem_fclose(instream);
@@ -1354,7 +1352,6 @@ static boolean ConvertMus(byte *musdata, int len, const char *filename)
 static void *I_WIN_RegisterSong(void *data, int len)
 {
     unsigned int i;
-    char *filename;
     midi_file_t *file;
 
     MIDIPROPTIMEDIV prop_timediv;
@@ -1364,24 +1361,17 @@ static void *I_WIN_RegisterSong(void *data, int len)
     // MUS files begin with "MUS"
     // Reject anything which doesnt have this signature
 
-    filename = M_TempFile("doom.mid");
-
     if (IsMid(data, len))
     {
-        M_WriteFile(filename, data, len);
+        file = MIDI_LoadFileFromMem(data, len);
     }
     else
     {
         // Assume a MUS file and try to convert
 
-        ConvertMus(data, len, filename);
+        file = ConvertMus(data, len);
     }
 
-    file = MIDI_LoadFile(filename);
-
-    M_remove(filename);
-    free(filename);
-
     if (file == NULL)
     {
         fprintf(stderr, "I_WIN_RegisterSong: Failed to load MID.\n");
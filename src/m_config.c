@@ -458,6 +458,18 @@ static default_t	doom_defaults_list[] =
 
     CONFIG_VARIABLE_KEY(key_demospeed),
 
+    //!
+    // Keyboard key to seek backward in a demo.
+    //
+
+    CONFIG_VARIABLE_KEY(key_demoseekback),
+
+    //!
+    // Keyboard key to seek forward in a demo.
+    //
+
+    CONFIG_VARIABLE_KEY(key_demoseekforward),
+
     //!
     // If non-zero, mouse input is enabled.  If zero, mouse input is
     // disabled.
@@ -950,6 +962,14 @@ static default_t extra_defaults_list[] =
 
     CONFIG_VARIABLE_INT(snd_pitchshift),
 
+    //!
+    // If non-zero, the position of sound effects is updated smoothly
+    // by the mixer instead of once per game tic, and the ear facing
+    // away from a sound hears it slightly later.
+    //
+
+    CONFIG_VARIABLE_INT(snd_spatial),
+
     //!
     // External command to invoke to perform MIDI playback. If set to
     // the empty string, SDL_mixer's internal MIDI playback is used.
@@ -974,6 +994,14 @@ static default_t extra_defaults_list[] =
 
     CONFIG_VARIABLE_INT_HEX(opl_io_port),
 
+    //!
+    // If non-zero, emulated OPL music is rendered ahead of time on its
+    // own thread, so that the audio callback only has to mix it. This
+    // allows smaller audio buffers on multi-core systems.
+    //
+
+    CONFIG_VARIABLE_INT(opl_render_thread),
+
     //!
     // Controls whether libsamplerate support is used for performing
     // sample rate conversions of sound effects.  Support for this
@@ -43,6 +43,8 @@ int key_use = ' ';
 int key_strafe = KEY_RALT;
 int key_speed = KEY_RSHIFT; 
 int key_demospeed = KEYP_PLUS; // [crispy]
+int key_demoseekback = 0; // [crispy]
+int key_demoseekforward = 0; // [crispy]
 int key_toggleautorun = KEY_CAPSLOCK; // [crispy]
 int key_togglenovert = 0; // [crispy]
 
@@ -309,6 +311,8 @@ void M_BindBaseControls(void)
     M_BindIntVariable("key_strafe",         &key_strafe);
     M_BindIntVariable("key_speed",          &key_speed);
     M_BindIntVariable("key_demospeed",      &key_demospeed); // [crispy]
+    M_BindIntVariable("key_demoseekback",   &key_demoseekback); // [crispy]
+    M_BindIntVariable("key_demoseekforward", &key_demoseekforward); // [crispy]
 
     M_BindIntVariable("mouseb_fire",        &mousebfire);
     M_BindIntVariable("mouseb_strafe",      &mousebstrafe);
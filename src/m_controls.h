@@ -34,6 +34,8 @@ extern int key_use;
 extern int key_strafe;
 extern int key_speed;
 extern int key_demospeed;  // [crispy]
+extern int key_demoseekback;  // [crispy]
+extern int key_demoseekforward;  // [crispy]
 
 extern int key_jump;
 extern int key_toggleautorun;
@@ -24,6 +24,7 @@
 #include "i_swap.h"
 #include "i_system.h"
 #include "m_misc.h"
+#include "memio.h"
 #include "midifile.h"
 
 #define HEADER_CHUNK_ID "MThd"
@@ -109,28 +110,20 @@ static boolean CheckChunkHeader(chunk_header_t *chunk,
 
 // Read a single byte.  Returns false on error.
 
-static boolean ReadByte(byte *result, FILE *stream)
+static boolean ReadByte(byte *result, MEMFILE *stream)
 {
-    int c;
-
-    c = fgetc(stream);
-
-    if (c == EOF)
+    if (mem_fread(result, 1, 1, stream) < 1)
     {
         fprintf(stderr, "ReadByte: Unexpected end of file\n");
         return false;
     }
-    else
-    {
-        *result = (byte) c;
 
-        return true;
-    }
+    return true;
 }
 
 // Read a variable-length value.
 
-static boolean ReadVariableLength(unsigned int *result, FILE *stream)
+static boolean ReadVariableLength(unsigned int *result, MEMFILE *stream)
 {
     int i;
     byte b = 0;
@@ -166,7 +159,7 @@ static boolean ReadVariableLength(unsigned int *result, FILE *stream)
 
 // Read a byte sequence into the data buffer.
 
-static void *ReadByteSequence(unsigned int num_bytes, FILE *stream)
+static void *ReadByteSequence(unsigned int num_bytes, MEMFILE *stream)
 {
     unsigned int i;
     byte *result;
@@ -204,7 +197,7 @@ static void *ReadByteSequence(unsigned int num_bytes, FILE *stream)
 
 static boolean ReadChannelEvent(midi_event_t *event,
                                 byte event_type, boolean two_param,
-                                FILE *stream)
+                                MEMFILE *stream)
 {
     byte b = 0;
 
@@ -244,7 +237,7 @@ static boolean ReadChannelEvent(midi_event_t *event,
 // Read sysex event:
 
 static boolean ReadSysExEvent(midi_event_t *event, int event_type,
-                              FILE *stream)
+                              MEMFILE *stream)
 {
     event->event_type = event_type;
 
@@ -270,7 +263,7 @@ static boolean ReadSysExEvent(midi_event_t *event, int event_type,
 
 // Read meta event:
 
-static boolean ReadMetaEvent(midi_event_t *event, FILE *stream)
+static boolean ReadMetaEvent(midi_event_t *event, MEMFILE *stream)
 {
     byte b = 0;
 
@@ -309,7 +302,7 @@ static boolean ReadMetaEvent(midi_event_t *event, FILE *stream)
 }
 
 static boolean ReadEvent(midi_event_t *event, unsigned int *last_event_type,
-                         FILE *stream)
+                         MEMFILE *stream)
 {
     byte event_type = 0;
 
@@ -334,7 +327,7 @@ static boolean ReadEvent(midi_event_t *event, unsigned int *last_event_type,
     {
         event_type = *last_event_type;
 
-        if (fseek(stream, -1, SEEK_CUR) < 0)
+        if (mem_fseek(stream, -1, MEM_SEEK_CUR) < 0)
         {
             fprintf(stderr, "ReadEvent: Unable to seek in stream\n");
             return false;
@@ -413,12 +406,12 @@ static void FreeEvent(midi_event_t *event)
 
 // Read and check the track chunk header
 
-static boolean ReadTrackHeader(midi_track_t *track, FILE *stream)
+static boolean ReadTrackHeader(midi_track_t *track, MEMFILE *stream)
 {
     size_t records_read;
     chunk_header_t chunk_header;
 
-    records_read = fread(&chunk_header, sizeof(chunk_header_t), 1, stream);
+    records_read = mem_fread(&chunk_header, sizeof(chunk_header_t), 1, stream);
 
     if (records_read < 1)
     {
@@ -435,7 +428,7 @@ static boolean ReadTrackHeader(midi_track_t *track, FILE *stream)
     return true;
 }
 
-static boolean ReadTrack(midi_track_t *track, FILE *stream)
+static boolean ReadTrack(midi_track_t *track, MEMFILE *stream)
 {
     midi_event_t *new_events;
     midi_event_t *event;
@@ -499,7 +492,7 @@ static void FreeTrack(midi_track_t *track)
     free(track->events);
 }
 
-static boolean ReadAllTracks(midi_file_t *file, FILE *stream)
+static boolean ReadAllTracks(midi_file_t *file, MEMFILE *stream)
 {
     unsigned int i;
 
@@ -529,12 +522,12 @@ static boolean ReadAllTracks(midi_file_t *file, FILE *stream)
 
 // Read and check the header chunk.
 
-static boolean ReadFileHeader(midi_file_t *file, FILE *stream)
+static boolean ReadFileHeader(midi_file_t *file, MEMFILE *stream)
 {
     size_t records_read;
     unsigned int format_type;
 
-    records_read = fread(&file->header, sizeof(midi_header_t), 1, stream);
+    records_read = mem_fread(&file->header, sizeof(midi_header_t), 1, stream);
 
     if (records_read < 1)
     {
@@ -581,16 +574,10 @@ void MIDI_FreeFile(midi_file_t *file)
     free(file);
 }
 
-#ifdef __WIIU__
-// Nasty Wii U MIDI file hack...
-extern void *midiBuffer;
-extern size_t midiBufferSize;
-#endif
-
-midi_file_t *MIDI_LoadFile(char *filename)
+midi_file_t *MIDI_LoadFileFromMem(void *buf, size_t buflen)
 {
     midi_file_t *file;
-    FILE *stream;
+    MEMFILE *stream;
 
     file = malloc(sizeof(midi_file_t));
 
@@ -604,44 +591,70 @@ midi_file_t *MIDI_LoadFile(char *filename)
     file->buffer = NULL;
     file->buffer_size = 0;
 
-    // Open file
+    // All event data is copied out of the buffer while parsing, so the
+    // caller is free to release it as soon as we return.
+
+    stream = mem_fopen_read(buf, buflen);
 
-#ifdef __WIIU__
-    if (strcmp(filename, "/tmp/doom.mid") == 0)
+    // Read MIDI file header
+
+    if (!ReadFileHeader(file, stream))
     {
-        stream = fmemopen(midiBuffer, midiBufferSize, "rb");
+        mem_fclose(stream);
+        MIDI_FreeFile(file);
+        return NULL;
     }
-    else
-#endif // __WIIU__
-    stream = M_fopen(filename, "rb");
 
-    if (stream == NULL)
+    // Read all tracks:
+
+    if (!ReadAllTracks(file, stream))
     {
-        fprintf(stderr, "MIDI_LoadFile: Failed to open '%s'\n", filename);
+        mem_fclose(stream);
         MIDI_FreeFile(file);
         return NULL;
     }
 
-    // Read MIDI file header
+    mem_fclose(stream);
 
-    if (!ReadFileHeader(file, stream))
+    return file;
+}
+
+midi_file_t *MIDI_LoadFile(char *filename)
+{
+    midi_file_t *file;
+    FILE *stream;
+    byte *buf;
+    long length;
+
+    // Open file
+
+    stream = M_fopen(filename, "rb");
+
+    if (stream == NULL)
     {
-        fclose(stream);
-        MIDI_FreeFile(file);
+        fprintf(stderr, "MIDI_LoadFile: Failed to open '%s'\n", filename);
         return NULL;
     }
 
-    // Read all tracks:
+    // Slurp the whole file and parse it from memory.
 
-    if (!ReadAllTracks(file, stream))
+    length = M_FileLength(stream);
+    buf = malloc(length);
+
+    if (buf == NULL || fread(buf, 1, length, stream) < length)
     {
+        fprintf(stderr, "MIDI_LoadFile: Failed to read '%s'\n", filename);
         fclose(stream);
-        MIDI_FreeFile(file);
+        free(buf);
         return NULL;
     }
 
     fclose(stream);
 
+    file = MIDI_LoadFileFromMem(buf, length);
+
+    free(buf);
+
     return file;
 }
 
@@ -173,6 +173,10 @@ typedef struct
 
 midi_file_t *MIDI_LoadFile(char *filename);
 
+// Load a MIDI file from a memory buffer.
+
+midi_file_t *MIDI_LoadFileFromMem(void *buf, size_t buflen);
+
 // Free a MIDI file.
 
 void MIDI_FreeFile(midi_file_t *file);
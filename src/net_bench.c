@@ -0,0 +1,461 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+//
+// Loopback network benchmark.  Runs a server and a number of scripted
+// bot clients in the same process, connected through the loopback
+// module with simulated packet loss and latency, and reports how the
+// netcode copes.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "doomtype.h"
+#include "d_event.h"
+#include "d_mode.h"
+#include "i_system.h"
+#include "i_timer.h"
+#include "m_argv.h"
+
+#include "net_bench.h"
+#include "net_client.h"
+#include "net_common.h"
+#include "net_defs.h"
+#include "net_loop.h"
+#include "net_server.h"
+
+// How many tics a bot may get ahead of the tics it has received back,
+// like the game does when it is waiting on other players.
+
+#define BENCH_LOOKAHEAD 8
+
+// Latencies are recorded in a histogram with 1ms buckets.
+
+#define MAX_LATENCY_MS 2000
+
+typedef struct
+{
+    net_client_instance_t *instance;
+
+    // Next tic to generate, and number of complete tics received.
+
+    int maketic;
+    int recvtic;
+
+    // Time each tic in the send window was generated.
+
+    int send_time[BACKUPTICS];
+
+    boolean disconnected;
+} bench_bot_t;
+
+static bench_bot_t bots[NET_MAXPLAYERS];
+static int num_bots;
+static bench_bot_t *current_bot;
+
+static unsigned int latency_histogram[MAX_LATENCY_MS + 1];
+static unsigned int num_latency_samples;
+
+static void SelectBot(int i)
+{
+    current_bot = &bots[i];
+    NET_Loop_SelectClient(i);
+    NET_CL_SetInstance(bots[i].instance);
+}
+
+// Called by the client code for each complete tic: record how long it
+// took from generating our own ticcmd to getting everyone's back.
+
+static void BotReceiveTic(ticcmd_t *ticcmds, boolean *playeringame)
+{
+    int latency;
+
+    if (ticcmds == NULL)
+    {
+        current_bot->disconnected = true;
+        return;
+    }
+
+    // The server does not wait for our own ticcmd before sending the
+    // others' to us, so the tic can arrive before we generated it.
+
+    if (current_bot->recvtic < current_bot->maketic)
+    {
+        latency = I_GetTimeMS()
+                - current_bot->send_time[current_bot->recvtic % BACKUPTICS];
+    }
+    else
+    {
+        latency = 0;
+    }
+
+    if (latency < 0)
+    {
+        latency = 0;
+    }
+    else if (latency > MAX_LATENCY_MS)
+    {
+        latency = MAX_LATENCY_MS;
+    }
+
+    ++latency_histogram[latency];
+    ++num_latency_samples;
+    ++current_bot->recvtic;
+}
+
+// Scripted input: each bot runs back and forth, strafes now and then,
+// turns, fires once a second and stands still one second in five, so
+// that the ticcmd diffs see a mix of changing and idle fields.
+
+static void BotTiccmd(int bot, int tic, ticcmd_t *cmd)
+{
+    memset(cmd, 0, sizeof(ticcmd_t));
+
+    if ((tic / TICRATE + bot) % 5 == 0)
+    {
+        return;
+    }
+
+    cmd->forwardmove = ((tic / TICRATE) & 1) ? 50 : -50;
+    cmd->sidemove = (tic / 7 + bot) % 3 == 0 ? 24 : 0;
+    cmd->angleturn = 256 * (bot + 1);
+
+    if (tic % TICRATE == 0)
+    {
+        cmd->buttons = BT_ATTACK;
+    }
+}
+
+// Give every bot and the server a chance to process their packets.
+
+static void RunAll(void)
+{
+    int i;
+
+    for (i = 0; i < num_bots; ++i)
+    {
+        SelectBot(i);
+        NET_CL_Run();
+
+        if (bots[i].disconnected)
+        {
+            I_Error("NET_Benchmark: Bot %d was disconnected", i);
+        }
+    }
+
+    NET_SV_Run();
+}
+
+static void ConnectBots(void)
+{
+    net_connect_data_t data;
+    net_addr_t *addr;
+    int i;
+
+    memset(&data, 0, sizeof(data));
+    data.gamemode = registered;
+    data.gamemission = doom;
+    data.max_players = num_bots;
+
+    for (i = 0; i < num_bots; ++i)
+    {
+        bots[i].instance = NET_CL_NewInstance(BotReceiveTic);
+        SelectBot(i);
+
+        addr = net_loop_client_module.ResolveAddress(NULL);
+
+        if (!NET_CL_Connect(addr, &data))
+        {
+            I_Error("NET_Benchmark: Bot %d failed to connect: %s",
+                    i, net_client_reject_reason);
+        }
+    }
+}
+
+static boolean BotWaitingForLaunch(void)
+{
+    return net_waiting_for_launch;
+}
+
+static boolean BotWaitingForStart(void)
+{
+    net_gamesettings_t settings;
+
+    return !NET_CL_GetSettings(&settings);
+}
+
+// Wait until no bot is waiting any more, or give up after five seconds.
+
+static void WaitForBots(boolean (*waiting)(void), const char *what)
+{
+    int start_time;
+    int i;
+
+    start_time = I_GetTimeMS();
+
+    for (;;)
+    {
+        RunAll();
+
+        for (i = 0; i < num_bots; ++i)
+        {
+            SelectBot(i);
+
+            if (waiting())
+            {
+                break;
+            }
+        }
+
+        if (i == num_bots)
+        {
+            return;
+        }
+
+        if (I_GetTimeMS() - start_time > 5000)
+        {
+            I_Error("NET_Benchmark: Timed out waiting for %s", what);
+        }
+
+        I_Sleep(1);
+    }
+}
+
+static void StartGame(void)
+{
+    net_gamesettings_t settings;
+    int i;
+
+    // The first bot to connect is the controller, and launches the game.
+
+    RunAll();
+    SelectBot(0);
+    NET_CL_LaunchGame();
+    WaitForBots(BotWaitingForLaunch, "launch");
+
+    memset(&settings, 0, sizeof(settings));
+    settings.ticdup = 1;
+    settings.extratics = 1;
+    settings.episode = 1;
+    settings.map = 1;
+    settings.skill = sk_medium;
+    settings.gameversion = exe_doom_1_9;
+    settings.new_sync = 1;
+
+    for (i = 0; i < num_bots; ++i)
+    {
+        SelectBot(i);
+        NET_CL_StartGame(&settings);
+    }
+
+    WaitForBots(BotWaitingForStart, "game start");
+}
+
+static int LatencyPercentile(int percent)
+{
+    unsigned int count, target;
+    int i;
+
+    target = (num_latency_samples * percent + 99) / 100;
+    count = 0;
+
+    for (i = 0; i <= MAX_LATENCY_MS; ++i)
+    {
+        count += latency_histogram[i];
+
+        if (count >= target && count > 0)
+        {
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+static int MaxLatency(void)
+{
+    int i;
+
+    for (i = MAX_LATENCY_MS; i > 0; --i)
+    {
+        if (latency_histogram[i] > 0)
+        {
+            break;
+        }
+    }
+
+    return i;
+}
+
+void NET_Benchmark(void)
+{
+    net_server_stats_t stats;
+    ticcmd_t cmd;
+    boolean progress;
+    int num_tics, loss, latency, jitter;
+    int start_time, elapsed;
+    int finished;
+    int i, p;
+
+    num_bots = 0;
+    p = M_CheckParmWithArgs("-netbench", 1);
+
+    if (p > 0)
+    {
+        num_bots = atoi(myargv[p + 1]);
+    }
+
+    if (num_bots < 1 || num_bots > NET_MAXPLAYERS)
+    {
+        I_Error("NET_Benchmark: Number of clients must be between 1 and %d",
+                NET_MAXPLAYERS);
+    }
+
+    //!
+    // @category net
+    // @arg <n>
+    //
+    // Number of tics each client sends in a network benchmark
+    // (default 2100, one minute of play).
+    //
+
+    num_tics = 60 * TICRATE;
+    p = M_CheckParmWithArgs("-netbench_tics", 1);
+    if (p > 0)
+        num_tics = atoi(myargv[p + 1]);
+
+    //!
+    // @category net
+    // @arg <percent>
+    //
+    // Percentage of packets to drop during a network benchmark.
+    //
+
+    loss = 0;
+    p = M_CheckParmWithArgs("-netbench_loss", 1);
+    if (p > 0)
+        loss = atoi(myargv[p + 1]);
+
+    //!
+    // @category net
+    // @arg <ms>
+    //
+    // One-way latency to simulate during a network benchmark.
+    //
+
+    latency = 0;
+    p = M_CheckParmWithArgs("-netbench_latency", 1);
+    if (p > 0)
+        latency = atoi(myargv[p + 1]);
+
+    //!
+    // @category net
+    // @arg <ms>
+    //
+    // Random extra delay of up to this many milliseconds for each packet
+    // during a network benchmark.  Packets can overtake each other, so
+    // this also reorders them.
+    //
+
+    jitter = 0;
+    p = M_CheckParmWithArgs("-netbench_jitter", 1);
+    if (p > 0)
+        jitter = atoi(myargv[p + 1]);
+
+    NET_OpenLog();
+    NET_CL_Init();
+
+    NET_SV_Init();
+    NET_SV_AddModule(&net_loop_server_module);
+
+    ConnectBots();
+    StartGame();
+
+    // Only impair the network for the game itself, so that the startup
+    // handshake does not time out.
+
+    NET_Loop_SetConditions(loss, latency, jitter);
+
+    start_time = I_GetTimeMS();
+
+    do
+    {
+        progress = false;
+        finished = 0;
+
+        for (i = 0; i < num_bots; ++i)
+        {
+            bench_bot_t *bot = &bots[i];
+
+            SelectBot(i);
+            NET_CL_Run();
+
+            if (bot->disconnected)
+            {
+                I_Error("NET_Benchmark: Bot %d was disconnected", i);
+            }
+
+            if (bot->maketic < num_tics
+             && bot->maketic - bot->recvtic < BENCH_LOOKAHEAD)
+            {
+                BotTiccmd(i, bot->maketic, &cmd);
+                bot->send_time[bot->maketic % BACKUPTICS] = I_GetTimeMS();
+                NET_CL_SendTiccmd(&cmd, bot->maketic);
+                ++bot->maketic;
+                progress = true;
+            }
+
+            if (bot->recvtic >= num_tics)
+            {
+                ++finished;
+            }
+        }
+
+        NET_SV_Run();
+
+        // Nothing to do until packets arrive or resends time out.
+
+        if (!progress)
+        {
+            I_Sleep(1);
+        }
+    } while (finished < num_bots);
+
+    elapsed = I_GetTimeMS() - start_time;
+
+    NET_Loop_SetConditions(0, 0, 0);
+    NET_SV_GetStats(&stats);
+
+    printf("Network benchmark: %d clients, %d tics in %d ms",
+           num_bots, num_tics, elapsed);
+    if (elapsed > 0)
+        printf(" (%.1f tics/s)", (num_tics * 1000.0) / elapsed);
+    printf("\n");
+    printf("  loss %d%%, latency %d ms, jitter %d ms\n",
+           loss, latency, jitter);
+    printf("  server: %u tics sent, %u resend requests, %u tics resent\n",
+           stats.tics_sent, stats.resend_requests, stats.tics_resent);
+    printf("  tic latency: p50 %d ms, p90 %d ms, p99 %d ms, max %d ms\n",
+           LatencyPercentile(50), LatencyPercentile(90),
+           LatencyPercentile(99), MaxLatency());
+
+    for (i = 0; i < num_bots; ++i)
+    {
+        SelectBot(i);
+        NET_CL_Disconnect();
+    }
+
+    I_Quit();
+}
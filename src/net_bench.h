@@ -0,0 +1,24 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+//
+// Loopback network benchmark.
+//
+
+#ifndef NET_BENCH_H
+#define NET_BENCH_H
+
+void NET_Benchmark(void);
+
+#endif /* #ifndef NET_BENCH_H */
+
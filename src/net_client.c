@@ -42,6 +42,7 @@
 #include "net_petname.h"
 #include "w_checksum.h"
 #include "w_wad.h"
+#include "z_zone.h"
 
 
 typedef enum
@@ -100,14 +101,70 @@ typedef struct
 } net_server_send_t;
 
 
-static net_connection_t client_connection;
-static net_clientstate_t client_state;
-static net_addr_t *server_addr;
-static net_context_t *client_context;
+// State of a client connection.  The game only ever has one, but the
+// loopback benchmark (net_bench.c) runs several in the same process.
 
-// game settings, as received from the server when the game started
+struct net_client_instance_s
+{
+    net_connection_t connection;
+    net_clientstate_t state;
+    net_addr_t *server_addr;
+    net_context_t *context;
+
+    // game settings, as received from the server when the game started
+
+    net_gamesettings_t settings;
+
+    // The last ticcmd constructed
+
+    ticcmd_t last_ticcmd;
+
+    // Buffer of ticcmd diffs being sent to the server
+
+    net_server_send_t send_queue[BACKUPTICS];
+
+    // Receive window
+
+    ticcmd_t recvwindow_cmd_base[NET_MAXPLAYERS];
+    int recvwindow_start;
+    net_server_recv_t recvwindow[BACKUPTICS];
+
+    // Whether we need to send an acknowledgement and
+    // when gamedata was last received.
+
+    boolean need_to_acknowledge;
+    unsigned int gamedata_recv_time;
+
+    // The latency (time between when we sent our command and we got all
+    // the other players' commands from the server) for the last tic we
+    // received. We include this latency in tics we send to the server so
+    // that they can adjust to us.
+    int last_latency;
+
+    // Clock synchronization filter state, see UpdateClockSync.
+
+    int last_error, cumul_error;
+
+    // Called with each complete tic received, or NULL for D_ReceiveTic.
+
+    net_receive_tic_t receive_tic;
 
-static net_gamesettings_t settings;
+    // Copies of the public net_client_* variables while this is not the
+    // current instance.
+
+    char *reject_reason;
+    boolean connected;
+    boolean received_wait_data;
+    net_waitdata_t wait_data;
+    boolean waiting_for_launch;
+    boolean drone;
+};
+
+static net_client_instance_t default_client;
+
+// Instance that the NET_CL_ functions currently act on.
+
+static net_client_instance_t *cl = &default_client;
 
 // Why did the server reject us?
 char *net_client_reject_reason = NULL;
@@ -134,31 +191,6 @@ char *net_player_name = NULL;
 
 boolean drone = false;
 
-// The last ticcmd constructed
-
-static ticcmd_t last_ticcmd;
-
-// Buffer of ticcmd diffs being sent to the server
-
-static net_server_send_t send_queue[BACKUPTICS];
-
-// Receive window
-
-static ticcmd_t recvwindow_cmd_base[NET_MAXPLAYERS];
-static int recvwindow_start;
-static net_server_recv_t recvwindow[BACKUPTICS];
-
-// Whether we need to send an acknowledgement and
-// when gamedata was last received.
-
-static boolean need_to_acknowledge;
-static unsigned int gamedata_recv_time;
-
-// The latency (time between when we sent our command and we got all
-// the other players' commands from the server) for the last tic we
-// received. We include this latency in tics we send to the server so
-// that they can adjust to us.
-static int last_latency;
 
 // Hash checksums of our wad directory and dehacked data.
 
@@ -169,13 +201,28 @@ sha1_digest_t net_local_deh_sha1sum;
 
 unsigned int net_local_is_freedoom;
 
-#define NET_CL_ExpandTicNum(b) NET_ExpandTicNum(recvwindow_start, (b))
+#define NET_CL_ExpandTicNum(b) NET_ExpandTicNum(cl->recvwindow_start, (b))
+
+// Pass a complete tic on to the game, or to whatever is driving this
+// client instance.
+
+static void ReceiveTic(ticcmd_t *ticcmds, boolean *playeringame)
+{
+    if (cl->receive_tic != NULL)
+    {
+        cl->receive_tic(ticcmds, playeringame);
+    }
+    else
+    {
+        D_ReceiveTic(ticcmds, playeringame);
+    }
+}
 
 // Called when we become disconnected from the server
 
 static void NET_CL_Disconnected(void)
 {
-    D_ReceiveTic(NULL, NULL);
+    ReceiveTic(NULL, NULL);
 }
 
 // Called when a packet is received from the server containing game
@@ -184,14 +231,13 @@ static void NET_CL_Disconnected(void)
 static void UpdateClockSync(unsigned int seq,
                             unsigned int remote_latency)
 {
-    static int last_error, cumul_error;
     int latency, error;
 
-    if (seq == send_queue[seq % BACKUPTICS].seq)
+    if (seq == cl->send_queue[seq % BACKUPTICS].seq)
     {
-        latency = I_GetTimeMS() - send_queue[seq % BACKUPTICS].time;
+        latency = I_GetTimeMS() - cl->send_queue[seq % BACKUPTICS].time;
     }
-    else if (seq > send_queue[seq % BACKUPTICS].seq)
+    else if (seq > cl->send_queue[seq % BACKUPTICS].seq)
     {
         // We have received the ticcmd from the server before we have
         // even sent ours
@@ -210,17 +256,17 @@ static void UpdateClockSync(unsigned int seq,
 
     // How does our latency compare to the worst other player?
     error = latency - remote_latency;
-    cumul_error += error;
+    cl->cumul_error += error;
 
     offsetms = KP * (FRACUNIT * error)
-             - KI * (FRACUNIT * cumul_error)
-             + (KD * FRACUNIT) * (last_error - error);
+             - KI * (FRACUNIT * cl->cumul_error)
+             + (KD * FRACUNIT) * (cl->last_error - error);
 
-    last_error = error;
-    last_latency = latency;
+    cl->last_error = error;
+    cl->last_latency = latency;
 
     NET_Log("client: latency %d, remote %d -> offset=%dms, cumul_error=%d",
-            latency, remote_latency, offsetms / FRACUNIT, cumul_error);
+            latency, remote_latency, offsetms / FRACUNIT, cl->cumul_error);
 }
 
 // Expand a net_full_ticcmd_t, applying the diffs in cmd->cmds as
@@ -237,7 +283,7 @@ static void NET_CL_ExpandFullTiccmd(net_full_ticcmd_t *cmd, unsigned int seq,
     
     for (i=0; i<NET_MAXPLAYERS; ++i)
     {
-        if (i == settings.consoleplayer && !drone)
+        if (i == cl->settings.consoleplayer && !drone)
         {
             continue;
         }
@@ -251,11 +297,11 @@ static void NET_CL_ExpandFullTiccmd(net_full_ticcmd_t *cmd, unsigned int seq,
             // Use the ticcmd diff to patch the previous ticcmd to
             // the new ticcmd
 
-            NET_TiccmdPatch(&recvwindow_cmd_base[i], diff, &ticcmds[i]);
+            NET_TiccmdPatch(&cl->recvwindow_cmd_base[i], diff, &ticcmds[i]);
 
             // Store a copy for next time
 
-            recvwindow_cmd_base[i] = ticcmds[i];
+            cl->recvwindow_cmd_base[i] = ticcmds[i];
         }
     }
 }
@@ -266,23 +312,23 @@ static void NET_CL_AdvanceWindow(void)
 {
     ticcmd_t ticcmds[NET_MAXPLAYERS];
 
-    while (recvwindow[0].active)
+    while (cl->recvwindow[0].active)
     {
         // Expand tic diff data into d_net.c structures
 
-        NET_CL_ExpandFullTiccmd(&recvwindow[0].cmd, recvwindow_start,
+        NET_CL_ExpandFullTiccmd(&cl->recvwindow[0].cmd, cl->recvwindow_start,
                                 ticcmds);
-        D_ReceiveTic(ticcmds, recvwindow[0].cmd.playeringame);
+        ReceiveTic(ticcmds, cl->recvwindow[0].cmd.playeringame);
 
         // Advance the window
 
-        memmove(recvwindow, recvwindow + 1,
+        memmove(cl->recvwindow, cl->recvwindow + 1,
                 sizeof(net_server_recv_t) * (BACKUPTICS - 1));
-        memset(&recvwindow[BACKUPTICS-1], 0, sizeof(net_server_recv_t));
+        memset(&cl->recvwindow[BACKUPTICS-1], 0, sizeof(net_server_recv_t));
 
-        ++recvwindow_start;
+        ++cl->recvwindow_start;
 
-        NET_Log("client: advanced receive window to %d", recvwindow_start);
+        NET_Log("client: advanced receive window to %d", cl->recvwindow_start);
     }
 }
 
@@ -294,7 +340,7 @@ static void NET_CL_Shutdown(void)
     {
         net_client_connected = false;
 
-        NET_ReleaseAddress(server_addr);
+        NET_ReleaseAddress(cl->server_addr);
 
         // Shut down network module, etc.  To do.
     }
@@ -302,7 +348,7 @@ static void NET_CL_Shutdown(void)
 
 void NET_CL_LaunchGame(void)
 {
-    NET_Conn_NewReliable(&client_connection, NET_PACKET_TYPE_LAUNCH);
+    NET_Conn_NewReliable(&cl->connection, NET_PACKET_TYPE_LAUNCH);
 }
 
 void NET_CL_StartGame(net_gamesettings_t *settings)
@@ -311,11 +357,11 @@ void NET_CL_StartGame(net_gamesettings_t *settings)
 
     // Start from a ticcmd of all zeros
 
-    memset(&last_ticcmd, 0, sizeof(ticcmd_t));
+    memset(&cl->last_ticcmd, 0, sizeof(ticcmd_t));
     
     // Send packet
 
-    packet = NET_Conn_NewReliable(&client_connection, 
+    packet = NET_Conn_NewReliable(&cl->connection, 
                                   NET_PACKET_TYPE_GAMESTART);
 
     NET_WriteSettings(packet, settings);
@@ -328,13 +374,13 @@ static void NET_CL_SendGameDataACK(void)
     packet = NET_NewPacket(10);
 
     NET_WriteInt16(packet, NET_PACKET_TYPE_GAMEDATA_ACK);
-    NET_WriteInt8(packet, recvwindow_start & 0xff);
+    NET_WriteInt8(packet, cl->recvwindow_start & 0xff);
 
-    NET_Conn_SendPacket(&client_connection, packet);
+    NET_Conn_SendPacket(&cl->connection, packet);
 
     NET_FreePacket(packet);
 
-    need_to_acknowledge = false;
+    cl->need_to_acknowledge = false;
 }
 
 static void NET_CL_SendTics(int start, int end)
@@ -360,7 +406,7 @@ static void NET_CL_SendTics(int start, int end)
     // Write the start tic and number of tics.  Send only the low byte
     // of start - it can be inferred by the server.
 
-    NET_WriteInt8(packet, recvwindow_start & 0xff);
+    NET_WriteInt8(packet, cl->recvwindow_start & 0xff);
     NET_WriteInt8(packet, start & 0xff);
     NET_WriteInt8(packet, end - start + 1);
 
@@ -370,16 +416,16 @@ static void NET_CL_SendTics(int start, int end)
     {
         net_server_send_t *sendobj;
 
-        sendobj = &send_queue[i % BACKUPTICS];
+        sendobj = &cl->send_queue[i % BACKUPTICS];
 
-        NET_WriteInt16(packet, last_latency);
+        NET_WriteInt16(packet, cl->last_latency);
 
-        NET_WriteTiccmdDiff(packet, &sendobj->cmd, settings.lowres_turn);
+        NET_WriteTiccmdDiff(packet, &sendobj->cmd, cl->settings.lowres_turn);
     }
     
     // Send the packet
 
-    NET_Conn_SendPacket(&client_connection, packet);
+    NET_Conn_SendPacket(&cl->connection, packet);
     
     // All done!
 
@@ -387,7 +433,7 @@ static void NET_CL_SendTics(int start, int end)
 
     // Acknowledgement has been sent as part of the packet
 
-    need_to_acknowledge = false;
+    cl->need_to_acknowledge = false;
 }
 
 // Add a new ticcmd to the send queue
@@ -400,21 +446,21 @@ void NET_CL_SendTiccmd(ticcmd_t *ticcmd, int maketic)
     
     // Calculate the difference to the last ticcmd
 
-    NET_TiccmdDiff(&last_ticcmd, ticcmd, &diff);
+    NET_TiccmdDiff(&cl->last_ticcmd, ticcmd, &diff);
     
     // Store in the send queue
 
-    sendobj = &send_queue[maketic % BACKUPTICS];
+    sendobj = &cl->send_queue[maketic % BACKUPTICS];
     sendobj->active = true;
     sendobj->seq = maketic;
     sendobj->time = I_GetTimeMS();
     sendobj->cmd = diff;
 
-    last_ticcmd = *ticcmd;
+    cl->last_ticcmd = *ticcmd;
 
     // Send to server.
 
-    starttic = maketic - settings.extratics;
+    starttic = maketic - cl->settings.extratics;
     endtic = maketic;
 
     if (starttic < 0)
@@ -450,8 +496,8 @@ static void NET_CL_ParseSYN(net_packet_t *packet)
 
     // We are now successfully connected.
     NET_Log("client: connected to server");
-    client_connection.state = NET_CONN_STATE_CONNECTED;
-    client_connection.protocol = protocol;
+    cl->connection.state = NET_CONN_STATE_CONNECTED;
+    cl->connection.protocol = protocol;
 
     // Even though we have negotiated a compatible protocol, the game may still
     // desync. Chocolate Doom's philosophy makes this unlikely, but if we're
@@ -488,10 +534,10 @@ static void NET_CL_ParseReject(net_packet_t *packet)
         return;
     }
 
-    if (client_connection.state == NET_CONN_STATE_CONNECTING)
+    if (cl->connection.state == NET_CONN_STATE_CONNECTING)
     {
-        client_connection.state = NET_CONN_STATE_DISCONNECTED;
-        client_connection.disconnect_reason = NET_DISCONNECT_REMOTE;
+        cl->connection.state = NET_CONN_STATE_DISCONNECTED;
+        cl->connection.disconnect_reason = NET_DISCONNECT_REMOTE;
         SetRejectReason(msg);
     }
 }
@@ -536,10 +582,10 @@ static void NET_CL_ParseLaunch(net_packet_t *packet)
 
     NET_Log("client: processing launch packet");
 
-    if (client_state != CLIENT_STATE_WAITING_LAUNCH)
+    if (cl->state != CLIENT_STATE_WAITING_LAUNCH)
     {
         NET_Log("client: error: not in waiting launch state, client_state=%d",
-                client_state);
+                cl->state);
         return;
     }
 
@@ -554,7 +600,7 @@ static void NET_CL_ParseLaunch(net_packet_t *packet)
     }
 
     net_client_wait_data.num_players = num_players;
-    client_state = CLIENT_STATE_WAITING_START;
+    cl->state = CLIENT_STATE_WAITING_START;
     NET_Log("client: now waiting for game start");
 }
 
@@ -562,50 +608,50 @@ static void NET_CL_ParseGameStart(net_packet_t *packet)
 {
     NET_Log("client: processing game start packet");
 
-    if (!NET_ReadSettings(packet, &settings))
+    if (!NET_ReadSettings(packet, &cl->settings))
     {
         NET_Log("client: error: failed to read settings");
         return;
     }
 
-    if (client_state != CLIENT_STATE_WAITING_START)
+    if (cl->state != CLIENT_STATE_WAITING_START)
     {
         NET_Log("client: error: not in waiting start state, client_state=%d",
-                client_state);
+                cl->state);
         return;
     }
 
-    if (settings.num_players > NET_MAXPLAYERS
-     || settings.consoleplayer >= (signed int) settings.num_players)
+    if (cl->settings.num_players > NET_MAXPLAYERS
+     || cl->settings.consoleplayer >= (signed int) cl->settings.num_players)
     {
         // insane values
         NET_Log("client: error: bad settings, num_players=%d, consoleplayer=%d",
-                settings.num_players, settings.consoleplayer);
+                cl->settings.num_players, cl->settings.consoleplayer);
         return;
     }
 
-    if ((drone && settings.consoleplayer >= 0)
-     || (!drone && settings.consoleplayer < 0))
+    if ((drone && cl->settings.consoleplayer >= 0)
+     || (!drone && cl->settings.consoleplayer < 0))
     {
         // Invalid player number: must be positive for real players,
         // negative for drones
         NET_Log("client: error: mismatch: drone=%d, consoleplayer=%d",
-                drone, settings.consoleplayer);
+                drone, cl->settings.consoleplayer);
         return;
     }
 
     NET_Log("client: beginning game state");
-    client_state = CLIENT_STATE_IN_GAME;
+    cl->state = CLIENT_STATE_IN_GAME;
 
     // Clear the receive window
 
-    memset(recvwindow, 0, sizeof(recvwindow));
-    recvwindow_start = 0;
-    memset(&recvwindow_cmd_base, 0, sizeof(recvwindow_cmd_base));
+    memset(cl->recvwindow, 0, sizeof(cl->recvwindow));
+    cl->recvwindow_start = 0;
+    memset(&cl->recvwindow_cmd_base, 0, sizeof(cl->recvwindow_cmd_base));
 
     // Clear the send queue
 
-    memset(&send_queue, 0x00, sizeof(send_queue));
+    memset(&cl->send_queue, 0x00, sizeof(cl->send_queue));
 }
 
 static void NET_CL_SendResendRequest(int start, int end)
@@ -620,7 +666,7 @@ static void NET_CL_SendResendRequest(int start, int end)
     NET_WriteInt16(packet, NET_PACKET_TYPE_GAMEDATA_RESEND);
     NET_WriteInt32(packet, start);
     NET_WriteInt8(packet, end - start + 1);
-    NET_Conn_SendPacket(&client_connection, packet);
+    NET_Conn_SendPacket(&cl->connection, packet);
     NET_FreePacket(packet);
 
     nowtime = I_GetTimeMS();
@@ -631,12 +677,12 @@ static void NET_CL_SendResendRequest(int start, int end)
     {
         int index;
 
-        index = i - recvwindow_start;
+        index = i - cl->recvwindow_start;
 
         if (index < 0 || index >= BACKUPTICS)
             continue;
 
-        recvwindow[index].resend_time = nowtime;
+        cl->recvwindow[index].resend_time = nowtime;
     }
 }
 
@@ -650,7 +696,7 @@ static void NET_CL_CheckResends(void)
     boolean maybe_deadlocked;
 
     nowtime = I_GetTimeMS();
-    maybe_deadlocked = nowtime - gamedata_recv_time > 1000;
+    maybe_deadlocked = nowtime - cl->gamedata_recv_time > 1000;
 
     resend_start = -1;
     resend_end = -1;
@@ -660,7 +706,7 @@ static void NET_CL_CheckResends(void)
         net_server_recv_t *recvobj;
         boolean need_resend;
 
-        recvobj = &recvwindow[i];
+        recvobj = &cl->recvwindow[i];
 
         // if need_resend is true, this tic needs another retransmit
         // request (300ms timeout)
@@ -695,11 +741,11 @@ static void NET_CL_CheckResends(void)
         {
             // End of a run of resend tics
             NET_Log("client: resend request timed out for %d-%d (%d)",
-                    recvwindow_start + resend_start,
-                    recvwindow_start + resend_end,
-                    recvwindow[resend_start].resend_time);
-            NET_CL_SendResendRequest(recvwindow_start + resend_start,
-                                     recvwindow_start + resend_end);
+                    cl->recvwindow_start + resend_start,
+                    cl->recvwindow_start + resend_end,
+                    cl->recvwindow[resend_start].resend_time);
+            NET_CL_SendResendRequest(cl->recvwindow_start + resend_start,
+                                     cl->recvwindow_start + resend_end);
             resend_start = -1;
         }
     }
@@ -707,21 +753,21 @@ static void NET_CL_CheckResends(void)
     if (resend_start >= 0)
     {
         NET_Log("client: resend request timed out for %d-%d (%d)",
-                recvwindow_start + resend_start,
-                recvwindow_start + resend_end,
-                recvwindow[resend_start].resend_time);
-        NET_CL_SendResendRequest(recvwindow_start + resend_start,
-                                 recvwindow_start + resend_end);
+                cl->recvwindow_start + resend_start,
+                cl->recvwindow_start + resend_end,
+                cl->recvwindow[resend_start].resend_time);
+        NET_CL_SendResendRequest(cl->recvwindow_start + resend_start,
+                                 cl->recvwindow_start + resend_end);
     }
 
     // We have received some data from the server and not acknowledged
     // it yet.  Normally this gets acknowledged when we send our game
     // data, but if the client is a drone we need to do this.
 
-    if (need_to_acknowledge && nowtime - gamedata_recv_time > 200)
+    if (cl->need_to_acknowledge && nowtime - cl->gamedata_recv_time > 200)
     {
         NET_Log("client: no game data received since %d: triggering ack",
-                gamedata_recv_time);
+                cl->gamedata_recv_time);
         NET_CL_SendGameDataACK();
     }
 }
@@ -733,6 +779,8 @@ static void NET_CL_CheckResends(void)
 static void NET_CL_ParseGameData(net_packet_t *packet)
 {
     net_server_recv_t *recvobj;
+    net_packed_tics_t packed;
+    boolean use_packed;
     unsigned int seq, num_tics;
     unsigned int nowtime;
     int resend_start, resend_end;
@@ -754,23 +802,40 @@ static void NET_CL_ParseGameData(net_packet_t *packet)
     // Whatever happens, we now need to send an acknowledgement of our
     // current receive point.
 
-    if (!need_to_acknowledge)
+    if (!cl->need_to_acknowledge)
     {
-        need_to_acknowledge = true;
-        gamedata_recv_time = nowtime;
+        cl->need_to_acknowledge = true;
+        cl->gamedata_recv_time = nowtime;
     }
 
     // Expand byte value into the full tic number
     seq = NET_CL_ExpandTicNum(seq);
     NET_Log("client: got game data, seq=%d, num_tics=%d", seq, num_tics);
 
+    use_packed = cl->connection.protocol == NET_PROTOCOL_CRISPY_DOOM_PACKED_TICS;
+
+    if (use_packed)
+    {
+        NET_BeginPackedTics(&packed, packet);
+    }
+
     for (i=0; i<num_tics; ++i)
     {
         net_full_ticcmd_t cmd;
+        boolean ok;
+
+        index = seq - cl->recvwindow_start + i;
 
-        index = seq - recvwindow_start + i;
+        if (use_packed)
+        {
+            ok = NET_ReadPackedTiccmd(&packed, &cmd, cl->settings.lowres_turn);
+        }
+        else
+        {
+            ok = NET_ReadFullTiccmd(packet, &cmd, cl->settings.lowres_turn);
+        }
 
-        if (!NET_ReadFullTiccmd(packet, &cmd, settings.lowres_turn))
+        if (!ok)
         {
             NET_Log("client: error: failed to read ticcmd %d", i);
             return;
@@ -785,7 +850,7 @@ static void NET_CL_ParseGameData(net_packet_t *packet)
 
         // Store in the receive window
 
-        recvobj = &recvwindow[index];
+        recvobj = &cl->recvwindow[index];
 
         recvobj->active = true;
         recvobj->cmd = cmd;
@@ -808,7 +873,7 @@ static void NET_CL_ParseGameData(net_packet_t *packet)
 
     //printf("CL: %p: %i\n", client, seq);
 
-    resend_end = seq - recvwindow_start;
+    resend_end = seq - cl->recvwindow_start;
 
     if (resend_end <= 0)
         return;
@@ -821,7 +886,7 @@ static void NET_CL_ParseGameData(net_packet_t *packet)
     
     while (index >= 0)
     {
-        recvobj = &recvwindow[index];
+        recvobj = &cl->recvwindow[index];
 
         if (recvobj->active)
         {
@@ -845,10 +910,10 @@ static void NET_CL_ParseGameData(net_packet_t *packet)
     if (resend_start < resend_end)
     {
         NET_Log("client: request resend for %d-%d before %d",
-                recvwindow_start + resend_start,
-                recvwindow_start + resend_end - 1, seq);
-        NET_CL_SendResendRequest(recvwindow_start + resend_start, 
-                                 recvwindow_start + resend_end - 1);
+                cl->recvwindow_start + resend_start,
+                cl->recvwindow_start + resend_end - 1, seq);
+        NET_CL_SendResendRequest(cl->recvwindow_start + resend_start, 
+                                 cl->recvwindow_start + resend_end - 1);
     }
 }
 
@@ -885,15 +950,15 @@ static void NET_CL_ParseResendRequest(net_packet_t *packet)
     // window of tics to only what we have.
 
     while (start <= end
-        && (!send_queue[start % BACKUPTICS].active
-         || send_queue[start % BACKUPTICS].seq != start))
+        && (!cl->send_queue[start % BACKUPTICS].active
+         || cl->send_queue[start % BACKUPTICS].seq != start))
     {
         ++start;
     }
      
     while (start <= end
-        && (!send_queue[end % BACKUPTICS].active
-         || send_queue[end % BACKUPTICS].seq != end))
+        && (!cl->send_queue[end % BACKUPTICS].active
+         || cl->send_queue[end % BACKUPTICS].seq != end))
     {
         --end;
     }
@@ -941,7 +1006,7 @@ static void NET_CL_ParsePacket(net_packet_t *packet)
             packet_type & ~NET_RELIABLE_PACKET);
     NET_LogPacket(packet);
 
-    if (NET_Conn_Packet(&client_connection, packet, &packet_type))
+    if (NET_Conn_Packet(&cl->connection, packet, &packet_type))
     {
         // Packet eaten by the common connection code
     }
@@ -1000,11 +1065,11 @@ void NET_CL_Run(void)
         return;
     }
     
-    while (NET_RecvPacket(client_context, &addr, &packet))
+    while (NET_RecvPacket(cl->context, &addr, &packet))
     {
         // only accept packets from the server
 
-        if (addr == server_addr)
+        if (addr == cl->server_addr)
         {
             NET_CL_ParsePacket(packet);
         }
@@ -1015,10 +1080,10 @@ void NET_CL_Run(void)
 
     // Run the common connection code to send any packets as needed
 
-    NET_Conn_Run(&client_connection);
+    NET_Conn_Run(&cl->connection);
 
-    if (client_connection.state == NET_CONN_STATE_DISCONNECTED
-     || client_connection.state == NET_CONN_STATE_DISCONNECTED_SLEEP)
+    if (cl->connection.state == NET_CONN_STATE_DISCONNECTED
+     || cl->connection.state == NET_CONN_STATE_DISCONNECTED_SLEEP)
     {
         NET_CL_Disconnected();
 
@@ -1026,10 +1091,10 @@ void NET_CL_Run(void)
     }
 
     net_waiting_for_launch =
-            client_connection.state == NET_CONN_STATE_CONNECTED
-         && client_state == CLIENT_STATE_WAITING_LAUNCH;
+            cl->connection.state == NET_CONN_STATE_CONNECTED
+         && cl->state == CLIENT_STATE_WAITING_LAUNCH;
 
-    if (client_state == CLIENT_STATE_IN_GAME)
+    if (cl->state == CLIENT_STATE_IN_GAME)
     {
         // Possibly advance the receive window
 
@@ -1054,7 +1119,7 @@ static void NET_CL_SendSYN(net_connect_data_t *data)
     NET_WriteProtocolList(packet);
     NET_WriteConnectData(packet, data);
     NET_WriteString(packet, net_player_name);
-    NET_Conn_SendPacket(&client_connection, packet);
+    NET_Conn_SendPacket(&cl->connection, packet);
     NET_FreePacket(packet);
 }
 
@@ -1065,7 +1130,7 @@ boolean NET_CL_Connect(net_addr_t *addr, net_connect_data_t *data)
     int last_send_time;
     boolean sent_hole_punch;
 
-    server_addr = addr;
+    cl->server_addr = addr;
     NET_ReferenceAddress(addr);
 
     memcpy(net_local_wad_sha1sum, data->wad_sha1sum, sizeof(sha1_digest_t));
@@ -1073,7 +1138,7 @@ boolean NET_CL_Connect(net_addr_t *addr, net_connect_data_t *data)
     net_local_is_freedoom = data->is_freedoom;
 
     // create a new network I/O context and add just the necessary module
-    client_context = NET_NewContext();
+    cl->context = NET_NewContext();
 
     // initialize module for client mode
     if (!addr->module->InitClient())
@@ -1082,20 +1147,20 @@ boolean NET_CL_Connect(net_addr_t *addr, net_connect_data_t *data)
         return false;
     }
 
-    NET_AddModule(client_context, addr->module);
+    NET_AddModule(cl->context, addr->module);
 
     net_client_connected = true;
     net_client_received_wait_data = false;
     sent_hole_punch = false;
 
-    NET_Conn_InitClient(&client_connection, addr, NET_PROTOCOL_UNKNOWN);
+    NET_Conn_InitClient(&cl->connection, addr, NET_PROTOCOL_UNKNOWN);
 
     // try to connect
     start_time = I_GetTimeMS();
     last_send_time = -1;
     SetRejectReason("Unknown reason");
 
-    while (client_connection.state == NET_CONN_STATE_CONNECTING)
+    while (cl->connection.state == NET_CONN_STATE_CONNECTING)
     {
         int nowtime = I_GetTimeMS();
 
@@ -1116,7 +1181,7 @@ boolean NET_CL_Connect(net_addr_t *addr, net_connect_data_t *data)
         if (!sent_hole_punch && nowtime - start_time > 2000)
         {
             NET_Log("client: no response to SYN, requesting hole punch");
-            NET_RequestHolePunch(client_context, addr);
+            NET_RequestHolePunch(cl->context, addr);
             sent_hole_punch = true;
         }
 
@@ -1130,12 +1195,12 @@ boolean NET_CL_Connect(net_addr_t *addr, net_connect_data_t *data)
         I_Sleep(1);
     }
 
-    if (client_connection.state == NET_CONN_STATE_CONNECTED)
+    if (cl->connection.state == NET_CONN_STATE_CONNECTED)
     {
         // connected ok!
         NET_Log("client: connected successfully");
         SetRejectReason(NULL);
-        client_state = CLIENT_STATE_WAITING_LAUNCH;
+        cl->state = CLIENT_STATE_WAITING_LAUNCH;
         drone = data->drone;
 
         return true;
@@ -1154,12 +1219,12 @@ boolean NET_CL_Connect(net_addr_t *addr, net_connect_data_t *data)
 
 boolean NET_CL_GetSettings(net_gamesettings_t *_settings)
 {
-    if (client_state != CLIENT_STATE_IN_GAME)
+    if (cl->state != CLIENT_STATE_IN_GAME)
     {
         return false;
     }
 
-    memcpy(_settings, &settings, sizeof(net_gamesettings_t));
+    memcpy(_settings, &cl->settings, sizeof(net_gamesettings_t));
 
     return true;
 }
@@ -1176,19 +1241,19 @@ void NET_CL_Disconnect(void)
     }
 
     NET_Log("client: beginning disconnect");
-    NET_Conn_Disconnect(&client_connection);
+    NET_Conn_Disconnect(&cl->connection);
 
     start_time = I_GetTimeMS();
 
-    while (client_connection.state != NET_CONN_STATE_DISCONNECTED
-        && client_connection.state != NET_CONN_STATE_DISCONNECTED_SLEEP)
+    while (cl->connection.state != NET_CONN_STATE_DISCONNECTED
+        && cl->connection.state != NET_CONN_STATE_DISCONNECTED_SLEEP)
     {
         if (I_GetTimeMS() - start_time > 5000)
         {
             // time out after 5 seconds
 
             NET_Log("client: no acknowledgement of disconnect received");
-            client_state = CLIENT_STATE_WAITING_START;
+            cl->state = CLIENT_STATE_WAITING_START;
 
             fprintf(stderr, "NET_CL_Disconnect: Timeout while disconnecting "
                             "from server\n");
@@ -1206,6 +1271,47 @@ void NET_CL_Disconnect(void)
     NET_CL_Shutdown();
 }
 
+// Allocate another client instance, whose complete tics are passed to
+// the given callback instead of the game.
+
+net_client_instance_t *NET_CL_NewInstance(net_receive_tic_t receive_tic)
+{
+    net_client_instance_t *instance;
+
+    instance = Z_Malloc(sizeof(net_client_instance_t), PU_STATIC, 0);
+    memset(instance, 0, sizeof(net_client_instance_t));
+    instance->receive_tic = receive_tic;
+
+    return instance;
+}
+
+// Select the client instance that the other NET_CL_ functions act on.
+// The public net_client_* variables always describe the current one.
+
+void NET_CL_SetInstance(net_client_instance_t *instance)
+{
+    if (instance == cl)
+    {
+        return;
+    }
+
+    cl->reject_reason = net_client_reject_reason;
+    cl->connected = net_client_connected;
+    cl->received_wait_data = net_client_received_wait_data;
+    cl->wait_data = net_client_wait_data;
+    cl->waiting_for_launch = net_waiting_for_launch;
+    cl->drone = drone;
+
+    cl = instance;
+
+    net_client_reject_reason = cl->reject_reason;
+    net_client_connected = cl->connected;
+    net_client_received_wait_data = cl->received_wait_data;
+    net_client_wait_data = cl->wait_data;
+    net_waiting_for_launch = cl->waiting_for_launch;
+    drone = cl->drone;
+}
+
 void NET_CL_Init(void)
 {
     // Try to set from the USER and USERNAME environment variables
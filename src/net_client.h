@@ -22,6 +22,12 @@
 #include "sha1.h"
 #include "net_defs.h"
 
+typedef struct net_client_instance_s net_client_instance_t;
+typedef void (*net_receive_tic_t)(ticcmd_t *ticcmds, boolean *playeringame);
+
+net_client_instance_t *NET_CL_NewInstance(net_receive_tic_t receive_tic);
+void NET_CL_SetInstance(net_client_instance_t *instance);
+
 boolean NET_CL_Connect(net_addr_t *addr, net_connect_data_t *data);
 void NET_CL_Disconnect(void);
 void NET_CL_Run(void);
@@ -275,6 +275,65 @@ void NET_Conn_Disconnect(net_connection_t *conn)
     }
 }
 
+// Lower wait_ms so that it does not run past the given deadline, which
+// has been reached once the time is greater than it.
+
+int NET_WaitUntil(int wait_ms, int nowtime, int deadline)
+{
+    int remaining = deadline - nowtime + 1;
+
+    if (remaining < 0)
+    {
+        remaining = 0;
+    }
+
+    return remaining < wait_ms ? remaining : wait_ms;
+}
+
+// Returns how long NET_Conn_Run can go uncalled before it has something
+// to do for this connection, capped at wait_ms.
+
+int NET_Conn_TimeToNextEvent(net_connection_t *conn, int wait_ms)
+{
+    int nowtime;
+
+    nowtime = I_GetTimeMS();
+
+    if (conn->state == NET_CONN_STATE_CONNECTED)
+    {
+        wait_ms = NET_WaitUntil(wait_ms, nowtime, conn->keepalive_recv_time
+                                + CONNECTION_TIMEOUT_LEN * 1000);
+        wait_ms = NET_WaitUntil(wait_ms, nowtime, conn->keepalive_send_time
+                                + KEEPALIVE_PERIOD * 1000);
+
+        if (conn->reliable_packets != NULL)
+        {
+            if (conn->reliable_packets->last_send_time < 0)
+            {
+                return 0;
+            }
+
+            wait_ms = NET_WaitUntil(wait_ms, nowtime,
+                conn->reliable_packets->last_send_time + 1000);
+        }
+    }
+    else if (conn->state == NET_CONN_STATE_DISCONNECTING)
+    {
+        if (conn->last_send_time < 0)
+        {
+            return 0;
+        }
+
+        wait_ms = NET_WaitUntil(wait_ms, nowtime, conn->last_send_time + 1000);
+    }
+    else if (conn->state == NET_CONN_STATE_DISCONNECTED_SLEEP)
+    {
+        wait_ms = NET_WaitUntil(wait_ms, nowtime, conn->last_send_time + 5000);
+    }
+
+    return wait_ms;
+}
+
 void NET_Conn_Run(net_connection_t *conn)
 {
     net_packet_t *packet;
@@ -28,6 +28,7 @@
 #include "net_common.h"
 #include "net_sdl.h"
 #include "net_server.h"
+#include "z_zone.h"
 
 // 
 // People can become confused about how dedicated servers work.  Game
@@ -61,20 +62,111 @@ static void CheckForClientOptions(void)
     }
 }
 
+// Each hosted game has its own server instance and its own socket, with
+// matching indexes.
+
+static net_server_t **instances;
+static int num_instances;
+
+static void SelectInstance(int i)
+{
+    NET_SDL_SelectServerSocket(i);
+    NET_SV_SetInstance(instances[i]);
+}
+
+static void StartInstances(void)
+{
+    int i;
+
+    instances = Z_Malloc(sizeof(net_server_t *) * num_instances,
+                         PU_STATIC, 0);
+
+    for (i = 0; i < num_instances; ++i)
+    {
+        instances[i] = NET_SV_NewInstance();
+        NET_SV_SetInstance(instances[i]);
+
+        // The first socket is opened when the module is initialized.
+
+        if (i > 0)
+        {
+            NET_SDL_SelectServerSocket(NET_SDL_OpenServerSocket());
+        }
+
+        NET_SV_Init();
+        NET_SV_AddModule(&net_sdl_module);
+        NET_SV_RegisterWithMaster();
+    }
+}
+
 void NET_DedicatedServer(void)
 {
+    int *wait_times;
+    int wait_ms, start_time, elapsed;
+    int i, p;
+
     CheckForClientOptions();
 
+    //!
+    // @category net
+    // @arg <n>
+    //
+    // When running a dedicated server, host n independent games in the
+    // one process, on consecutive UDP ports starting from the one given
+    // with -port.
+    //
+
+    num_instances = 1;
+    p = M_CheckParmWithArgs("-instances", 1);
+
+    if (p > 0)
+    {
+        num_instances = atoi(myargv[p + 1]);
+
+        if (num_instances < 1)
+        {
+            I_Error("NET_DedicatedServer: Invalid number of instances: %s",
+                    myargv[p + 1]);
+        }
+    }
+
     NET_OpenLog();
-    NET_SV_Init();
-    NET_SV_AddModule(&net_sdl_module);
-    NET_SV_RegisterWithMaster();
+    StartInstances();
+
+    wait_times = Z_Malloc(sizeof(int) * num_instances, PU_STATIC, 0);
 
     while (true)
     {
-        NET_SV_Run();
-        // TODO: Block on socket instead of polling.
-        I_Sleep(1);
+        // Sleep until a packet arrives or a server next has something
+        // to do (resends, keepalives, timeouts), rather than polling.
+
+        wait_ms = 1000;
+
+        for (i = 0; i < num_instances; ++i)
+        {
+            SelectInstance(i);
+            wait_times[i] = NET_SV_TimeToNextEvent(1000);
+
+            if (wait_times[i] < wait_ms)
+            {
+                wait_ms = wait_times[i];
+            }
+        }
+
+        start_time = I_GetTimeMS();
+        NET_SDL_WaitForPacket(wait_ms);
+        elapsed = I_GetTimeMS() - start_time;
+
+        // Only run the games that have received something or are due.
+
+        for (i = 0; i < num_instances; ++i)
+        {
+            if (wait_times[i] <= elapsed || NET_SDL_ServerSocketReady(i))
+            {
+                SelectInstance(i);
+                NET_SV_Run();
+            }
+        }
     }
 }
 
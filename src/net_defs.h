@@ -123,6 +123,12 @@ typedef enum
     // number in this enum.
     NET_PROTOCOL_CHOCOLATE_DOOM_0,
 
+    // [crispy] As above, but game data sent from the server carries its
+    // batch of tics bit-packed and delta-coded across tics and players
+    // (see NET_WritePackedTiccmd), and the server coalesces every tic
+    // that is ready for a client into a single packet.
+    NET_PROTOCOL_CRISPY_DOOM_PACKED_TICS,
+
     // Add your own protocol here; be sure to add a name for it to the list
     // in net_common.c too.
 
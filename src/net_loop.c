@@ -17,75 +17,185 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "doomtype.h"
 #include "i_system.h"
+#include "i_timer.h"
 #include "m_misc.h"
 #include "net_defs.h"
 #include "net_loop.h"
 #include "net_packet.h"
 
-#define MAX_QUEUE_SIZE 16
+#define MAX_QUEUE_SIZE 64
 
 typedef struct
 {
-    net_packet_t *packets[MAX_QUEUE_SIZE];
-    int head, tail;
+    net_packet_t *packet;
+
+    // Address the packet was sent from, as seen by the receiver.
+
+    net_addr_t *addr;
+
+    // Time at which the packet "arrives".
+
+    int deliver_time;
+} queued_packet_t;
+
+typedef struct
+{
+    queued_packet_t packets[MAX_QUEUE_SIZE];
+    int num_packets;
 } packet_queue_t;
 
-static packet_queue_t client_queue;
+// The game only ever has a single client end, but the loopback
+// benchmark (net_bench.c) connects several to the same server.  Each
+// one appears to the server as a separate address.
+
+typedef struct
+{
+    packet_queue_t queue;
+    net_addr_t addr;
+} loop_client_t;
+
+static loop_client_t loop_clients[MAXNETNODES];
+static int current_client = 0;
+
 static packet_queue_t server_queue;
 static net_addr_t client_addr;
-static net_addr_t server_addr;
+
+// Simulated network conditions, for benchmarking.
+
+static int loss_percent = 0;
+static int latency_ms = 0;
+static int jitter_ms = 0;
 
 static void QueueInit(packet_queue_t *queue)
 {
-    queue->head = queue->tail = 0;
+    int i;
+
+    for (i = 0; i < queue->num_packets; ++i)
+    {
+        NET_FreePacket(queue->packets[i].packet);
+    }
+
+    queue->num_packets = 0;
 }
 
-static void QueuePush(packet_queue_t *queue, net_packet_t *packet)
+static void QueuePush(packet_queue_t *queue, net_packet_t *packet,
+                      net_addr_t *addr)
 {
-    int new_tail;
-
-    new_tail = (queue->tail + 1) % MAX_QUEUE_SIZE;
+    queued_packet_t *entry;
 
-    if (new_tail == queue->head)
+    if (queue->num_packets >= MAX_QUEUE_SIZE
+     || (loss_percent > 0 && rand() % 100 < loss_percent))
     {
-        // queue is full
-        
+        // queue is full, or the packet got "lost"
+
+        NET_FreePacket(packet);
         return;
     }
 
-    queue->packets[queue->tail] = packet;
-    queue->tail = new_tail;
+    entry = &queue->packets[queue->num_packets];
+    entry->packet = packet;
+    entry->addr = addr;
+    entry->deliver_time = 0;
+
+    // Random jitter on top of the latency lets packets overtake each
+    // other, so that they arrive out of order.
+
+    if (latency_ms > 0 || jitter_ms > 0)
+    {
+        entry->deliver_time = I_GetTimeMS() + latency_ms;
+
+        if (jitter_ms > 0)
+        {
+            entry->deliver_time += rand() % (jitter_ms + 1);
+        }
+    }
+
+    ++queue->num_packets;
 }
 
-static net_packet_t *QueuePop(packet_queue_t *queue)
+static net_packet_t *QueuePop(packet_queue_t *queue, net_addr_t **addr)
 {
     net_packet_t *packet;
-    
-    if (queue->tail == queue->head)
+    int nowtime;
+    int best;
+    int i;
+
+    if (queue->num_packets == 0)
     {
         // queue empty
 
         return NULL;
     }
 
-    packet = queue->packets[queue->head];
-    queue->head = (queue->head + 1) % MAX_QUEUE_SIZE;
+    // Find the earliest packet that has arrived.  Packets with the same
+    // arrival time come out in the order they were sent.
+
+    nowtime = I_GetTimeMS();
+    best = -1;
+
+    for (i = 0; i < queue->num_packets; ++i)
+    {
+        if (queue->packets[i].deliver_time <= nowtime
+         && (best < 0 || queue->packets[i].deliver_time
+                       < queue->packets[best].deliver_time))
+        {
+            best = i;
+        }
+    }
+
+    if (best < 0)
+    {
+        return NULL;
+    }
+
+    packet = queue->packets[best].packet;
+    *addr = queue->packets[best].addr;
+
+    --queue->num_packets;
+    memmove(&queue->packets[best], &queue->packets[best + 1],
+            sizeof(queued_packet_t) * (queue->num_packets - best));
 
     return packet;
 }
 
+// Select the client end used by the client module from now on.
+
+void NET_Loop_SelectClient(int index)
+{
+    current_client = index;
+}
+
+// Simulate an unreliable network: drop the given percentage of packets,
+// and delay the rest by latency plus a random amount up to jitter.
+
+void NET_Loop_SetConditions(int loss, int latency, int jitter)
+{
+    loss_percent = loss;
+    latency_ms = latency;
+    jitter_ms = jitter;
+}
+
 //-----------------------------------------------------------------------------
 //
 // Client end code
 //
 //-----------------------------------------------------------------------------
 
+static net_addr_t *LoopClientAddr(int index)
+{
+    loop_clients[index].addr.module = &net_loop_server_module;
+    loop_clients[index].addr.handle = &loop_clients[index];
+
+    return &loop_clients[index].addr;
+}
+
 static boolean NET_CL_InitClient(void)
 {
-    QueueInit(&client_queue);
+    QueueInit(&loop_clients[current_client].queue);
 
     return true;
 }
@@ -98,21 +208,21 @@ static boolean NET_CL_InitServer(void)
 
 static void NET_CL_SendPacket(net_addr_t *addr, net_packet_t *packet)
 {
-    QueuePush(&server_queue, NET_PacketDup(packet));
+    QueuePush(&server_queue, NET_PacketDup(packet),
+              LoopClientAddr(current_client));
 }
 
 static boolean NET_CL_RecvPacket(net_addr_t **addr, net_packet_t **packet)
 {
     net_packet_t *popped;
 
-    popped = QueuePop(&client_queue);
+    popped = QueuePop(&loop_clients[current_client].queue, addr);
 
     if (popped != NULL)
     {
         *packet = popped;
-        *addr = &client_addr;
         client_addr.module = &net_loop_client_module;
-        
+
         return true;
     }
 
@@ -174,21 +284,22 @@ static boolean NET_SV_InitServer(void)
 
 static void NET_SV_SendPacket(net_addr_t *addr, net_packet_t *packet)
 {
-    QueuePush(&client_queue, NET_PacketDup(packet));
+    loop_client_t *client = addr->handle;
+
+    client_addr.module = &net_loop_client_module;
+    QueuePush(&client->queue, NET_PacketDup(packet), &client_addr);
 }
 
 static boolean NET_SV_RecvPacket(net_addr_t **addr, net_packet_t **packet)
 {
     net_packet_t *popped;
 
-    popped = QueuePop(&server_queue);
+    popped = QueuePop(&server_queue, addr);
 
     if (popped != NULL)
     {
         *packet = popped;
-        *addr = &server_addr;
-        server_addr.module = &net_loop_server_module;
-        
+
         return true;
     }
 
@@ -208,8 +319,7 @@ static net_addr_t *NET_SV_ResolveAddress(const char *address)
 {
     if (address == NULL)
     {
-        server_addr.module = &net_loop_server_module;
-        return &server_addr;
+        return LoopClientAddr(current_client);
     }
     else
     {
@@ -23,5 +23,8 @@
 extern net_module_t net_loop_client_module;
 extern net_module_t net_loop_server_module;
 
+void NET_Loop_SelectClient(int index);
+void NET_Loop_SetConditions(int loss, int latency, int jitter);
+
 #endif /* #ifndef NET_LOOP_H */
 
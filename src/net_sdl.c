@@ -21,6 +21,7 @@
 
 #include "doomtype.h"
 #include "i_system.h"
+#include "i_timer.h"
 #include "m_argv.h"
 #include "m_misc.h"
 #include "net_defs.h"
@@ -45,25 +46,82 @@ static boolean initted = false;
 static int port = DEFAULT_PORT;
 static UDPsocket udpsocket;
 static UDPpacket *recvpacket;
+static SDLNet_SocketSet socketset = NULL;
 
-typedef struct
+// When hosting several games, one socket per game, on consecutive ports.
+// udpsocket is whichever of these is currently selected.
+
+static UDPsocket *server_sockets = NULL;
+static int num_server_sockets = 0;
+
+// Addresses are kept in a hash table keyed on host and port, so that
+// looking up the source of each received packet does not slow down as
+// the number of addresses grows.
+
+#define ADDR_TABLE_MIN_SIZE 64
+
+// Addresses that nothing holds a reference to (eg. the source of a
+// query that was answered and dropped) are freed after this long.
+
+#define ADDR_EXPIRE_TIME 10000
+
+typedef struct addrpair_s addrpair_t;
+
+struct addrpair_s
 {
     net_addr_t net_addr;
     IPaddress sdl_addr;
-} addrpair_t;
+    int last_seen;
+    addrpair_t *next;
+};
+
+static addrpair_t **addr_table = NULL;
+static unsigned int addr_table_size = 0;
+static unsigned int num_addrs = 0;
+static int last_expire_time = 0;
 
-static addrpair_t **addr_table;
-static int addr_table_size = -1;
+static unsigned int AddressHash(IPaddress *addr)
+{
+    unsigned int hash;
 
-// Initializes the address table
+    hash = (addr->host * 2654435761U) ^ (addr->port * 40503U);
 
-static void NET_SDL_InitAddrTable(void)
+    return (hash ^ (hash >> 16)) & (addr_table_size - 1);
+}
+
+// (Re)allocates the hash table with the given number of buckets, which
+// must be a power of two.
+
+static void NET_SDL_ResizeAddrTable(unsigned int new_size)
 {
-    addr_table_size = 16;
+    addrpair_t **old_table;
+    unsigned int old_size;
+    addrpair_t *entry, *next;
+    unsigned int i, bucket;
+
+    old_table = addr_table;
+    old_size = addr_table_size;
 
+    addr_table_size = new_size;
     addr_table = Z_Malloc(sizeof(addrpair_t *) * addr_table_size,
                           PU_STATIC, 0);
     memset(addr_table, 0, sizeof(addrpair_t *) * addr_table_size);
+
+    for (i=0; i<old_size; ++i)
+    {
+        for (entry = old_table[i]; entry != NULL; entry = next)
+        {
+            next = entry->next;
+            bucket = AddressHash(&entry->sdl_addr);
+            entry->next = addr_table[bucket];
+            addr_table[bucket] = entry;
+        }
+    }
+
+    if (old_table != NULL)
+    {
+        Z_Free(old_table);
+    }
 }
 
 static boolean AddressesEqual(IPaddress *a, IPaddress *b)
@@ -72,85 +130,118 @@ static boolean AddressesEqual(IPaddress *a, IPaddress *b)
         && a->port == b->port;
 }
 
-// Finds an address by searching the table.  If the address is not found,
-// it is added to the table.
+// Frees every address that has not been referenced since it was last
+// seen, and was last seen a while ago.  The whole table is walked, so
+// this only happens once per expiry period.
 
-static net_addr_t *NET_SDL_FindAddress(IPaddress *addr)
+static void NET_SDL_ExpireAddresses(int nowtime)
 {
-    addrpair_t *new_entry;
-    int empty_entry = -1;
-    int i;
+    addrpair_t **link, *entry;
+    unsigned int i;
 
-    if (addr_table_size < 0)
+    if (nowtime - last_expire_time < ADDR_EXPIRE_TIME)
     {
-        NET_SDL_InitAddrTable();
+        return;
     }
 
+    last_expire_time = nowtime;
+
     for (i=0; i<addr_table_size; ++i)
     {
-        if (addr_table[i] != NULL
-         && AddressesEqual(addr, &addr_table[i]->sdl_addr))
+        link = &addr_table[i];
+
+        while (*link != NULL)
         {
-            return &addr_table[i]->net_addr;
+            entry = *link;
+
+            if (entry->net_addr.refcount <= 0
+             && nowtime - entry->last_seen >= ADDR_EXPIRE_TIME)
+            {
+                *link = entry->next;
+                Z_Free(entry);
+                --num_addrs;
+            }
+            else
+            {
+                link = &entry->next;
+            }
         }
+    }
+}
+
+// Finds an address by searching the table.  If the address is not found,
+// it is added to the table.
+
+static net_addr_t *NET_SDL_FindAddress(IPaddress *addr)
+{
+    addrpair_t *entry;
+    unsigned int bucket;
+    int nowtime;
+
+    nowtime = I_GetTimeMS();
 
-        if (empty_entry < 0 && addr_table[i] == NULL)
-            empty_entry = i;
+    if (addr_table_size == 0)
+    {
+        NET_SDL_ResizeAddrTable(ADDR_TABLE_MIN_SIZE);
+        last_expire_time = nowtime;
     }
 
-    // Was not found in list.  We need to add it.
+    NET_SDL_ExpireAddresses(nowtime);
 
-    // Is there any space in the table? If not, increase the table size
+    bucket = AddressHash(addr);
 
-    if (empty_entry < 0)
+    for (entry = addr_table[bucket]; entry != NULL; entry = entry->next)
     {
-        addrpair_t **new_addr_table;
-        int new_addr_table_size;
-
-        // after reallocing, we will add this in as the first entry
-        // in the new block of memory
-
-        empty_entry = addr_table_size;
-        
-        // allocate a new array twice the size, init to 0 and copy 
-        // the existing table in.  replace the old table.
-
-        new_addr_table_size = addr_table_size * 2;
-        new_addr_table = Z_Malloc(sizeof(addrpair_t *) * new_addr_table_size,
-                                  PU_STATIC, 0);
-        memset(new_addr_table, 0, sizeof(addrpair_t *) * new_addr_table_size);
-        memcpy(new_addr_table, addr_table, 
-               sizeof(addrpair_t *) * addr_table_size);
-        Z_Free(addr_table);
-        addr_table = new_addr_table;
-        addr_table_size = new_addr_table_size;
+        if (AddressesEqual(addr, &entry->sdl_addr))
+        {
+            entry->last_seen = nowtime;
+            return &entry->net_addr;
+        }
     }
 
-    // Add a new entry
-    
-    new_entry = Z_Malloc(sizeof(addrpair_t), PU_STATIC, 0);
+    // Was not found in list.  We need to add it, growing the table
+    // first if the chains are getting long.
 
-    new_entry->sdl_addr = *addr;
-    new_entry->net_addr.refcount = 0;
-    new_entry->net_addr.handle = &new_entry->sdl_addr;
-    new_entry->net_addr.module = &net_sdl_module;
+    if (num_addrs >= addr_table_size * 2)
+    {
+        NET_SDL_ResizeAddrTable(addr_table_size * 2);
+        bucket = AddressHash(addr);
+    }
+
+    entry = Z_Malloc(sizeof(addrpair_t), PU_STATIC, 0);
 
-    addr_table[empty_entry] = new_entry;
+    entry->sdl_addr = *addr;
+    entry->net_addr.refcount = 0;
+    entry->net_addr.handle = &entry->sdl_addr;
+    entry->net_addr.module = &net_sdl_module;
+    entry->last_seen = nowtime;
 
-    return &new_entry->net_addr;
+    entry->next = addr_table[bucket];
+    addr_table[bucket] = entry;
+    ++num_addrs;
+
+    return &entry->net_addr;
 }
 
 static void NET_SDL_FreeAddress(net_addr_t *addr)
 {
-    int i;
-    
-    for (i=0; i<addr_table_size; ++i)
+    addrpair_t **link, *entry;
+
+    if (addr_table_size > 0)
     {
-        if (addr == &addr_table[i]->net_addr)
+        link = &addr_table[AddressHash((IPaddress *) addr->handle)];
+
+        for (entry = *link; entry != NULL; entry = *link)
         {
-            Z_Free(addr_table[i]);
-            addr_table[i] = NULL;
-            return;
+            if (addr == &entry->net_addr)
+            {
+                *link = entry->next;
+                Z_Free(entry);
+                --num_addrs;
+                return;
+            }
+
+            link = &entry->next;
         }
     }
 
@@ -196,6 +287,22 @@ static boolean NET_SDL_InitClient(void)
     return true;
 }
 
+static void AddServerSocket(UDPsocket sock)
+{
+    server_sockets = I_Realloc(server_sockets,
+                               sizeof(UDPsocket) * (num_server_sockets + 1));
+    server_sockets[num_server_sockets] = sock;
+    ++num_server_sockets;
+
+    // Rebuilt on the next call to NET_SDL_WaitForPacket.
+
+    if (socketset != NULL)
+    {
+        SDLNet_FreeSocketSet(socketset);
+        socketset = NULL;
+    }
+}
+
 static boolean NET_SDL_InitServer(void)
 {
     int p;
@@ -216,6 +323,8 @@ static boolean NET_SDL_InitServer(void)
         I_Error("NET_SDL_InitServer: Unable to bind to port %i", port);
     }
 
+    AddServerSocket(udpsocket);
+
     recvpacket = SDLNet_AllocPacket(1500);
 #ifdef DROP_PACKETS
     srand(time(NULL));
@@ -367,6 +476,77 @@ net_addr_t *NET_SDL_ResolveAddress(const char *address)
     }
 }
 
+// Block until a packet arrives on our socket, or until timeout_ms
+// milliseconds have passed.  Returns true if a packet is waiting.
+
+boolean NET_SDL_WaitForPacket(int timeout_ms)
+{
+    if (!initted)
+    {
+        I_Sleep(timeout_ms);
+        return false;
+    }
+
+    if (socketset == NULL)
+    {
+        int i;
+
+        if (num_server_sockets > 0)
+        {
+            socketset = SDLNet_AllocSocketSet(num_server_sockets);
+
+            for (i = 0; i < num_server_sockets; ++i)
+            {
+                SDLNet_UDP_AddSocket(socketset, server_sockets[i]);
+            }
+        }
+        else
+        {
+            socketset = SDLNet_AllocSocketSet(1);
+            SDLNet_UDP_AddSocket(socketset, udpsocket);
+        }
+    }
+
+    return SDLNet_CheckSockets(socketset, timeout_ms) > 0;
+}
+
+// Open a server socket for an additional hosted game, on the port after
+// the last one opened.  Returns its index for NET_SDL_SelectServerSocket.
+
+int NET_SDL_OpenServerSocket(void)
+{
+    UDPsocket sock;
+    int sock_port;
+
+    sock_port = port + num_server_sockets;
+    sock = SDLNet_UDP_Open(sock_port);
+
+    if (sock == NULL)
+    {
+        I_Error("NET_SDL_OpenServerSocket: Unable to bind to port %i",
+                sock_port);
+    }
+
+    AddServerSocket(sock);
+
+    return num_server_sockets - 1;
+}
+
+// Send and receive through the given server socket from now on.
+
+void NET_SDL_SelectServerSocket(int index)
+{
+    udpsocket = server_sockets[index];
+}
+
+// After NET_SDL_WaitForPacket, check whether the given server socket
+// has a packet waiting.
+
+boolean NET_SDL_ServerSocketReady(int index)
+{
+    return SDLNet_SocketReady(server_sockets[index]) != 0;
+}
+
 // Complete module
 
 net_module_t net_sdl_module =
@@ -426,6 +606,30 @@ net_addr_t *NET_NULL_ResolveAddress(const char *address)
 }
 
 
+boolean NET_SDL_WaitForPacket(int timeout_ms)
+{
+    I_Sleep(timeout_ms);
+    return false;
+}
+
+
+int NET_SDL_OpenServerSocket(void)
+{
+    return -1;
+}
+
+
+void NET_SDL_SelectServerSocket(int index)
+{
+}
+
+
+boolean NET_SDL_ServerSocketReady(int index)
+{
+    return false;
+}
+
+
 net_module_t net_sdl_module =
 {
     NET_NULL_InitClient,
@@ -22,5 +22,10 @@
 
 extern net_module_t net_sdl_module;
 
+boolean NET_SDL_WaitForPacket(int timeout_ms);
+int NET_SDL_OpenServerSocket(void);
+void NET_SDL_SelectServerSocket(int index);
+boolean NET_SDL_ServerSocketReady(int index);
+
 #endif /* #ifndef NET_SDL_H */
 
@@ -38,6 +38,8 @@
 #include "net_server.h"
 #include "net_sdl.h"
 #include "net_structrw.h"
+#include "net_svdemo.h"
+#include "z_zone.h"
 
 // How often to refresh our registration with the master server.
 #define MASTER_REFRESH_PERIOD 30  /* twice per minute */
@@ -143,27 +145,46 @@ typedef struct
     net_ticdiff_t diff;
 } net_client_recv_t;
 
-static net_server_state_t server_state;
-static boolean server_initialized = false;
-static net_client_t clients[MAXNETNODES];
-static net_client_t *sv_players[NET_MAXPLAYERS];
-static net_context_t *server_context;
-static unsigned int sv_gamemode;
-static unsigned int sv_gamemission;
-static net_gamesettings_t sv_settings;
+// State of a single server instance.  A process normally only runs
+// one, but a dedicated server can host several independent games.
 
-// For registration with master server:
+struct net_server_s
+{
+    net_server_state_t state;
+    boolean initialized;
+    boolean work_pending;
+    net_client_t clients[MAXNETNODES];
+    net_client_t *players[NET_MAXPLAYERS];
+    net_context_t *context;
+    unsigned int gamemode;
+    unsigned int gamemission;
+    net_gamesettings_t settings;
+
+    // For registration with master server:
+
+    net_addr_t *master_server;
+    unsigned int master_refresh_time;
+    unsigned int master_resolve_time;
+
+    // receive window
+
+    unsigned int recvwindow_start;
+    net_client_recv_t recvwindow[BACKUPTICS][NET_MAXPLAYERS];
 
-static net_addr_t *master_server = NULL;
-static unsigned int master_refresh_time;
-static unsigned int master_resolve_time;
+    net_server_stats_t stats;
 
-// receive window
+    // Recording of the current game, if requested.
 
-static unsigned int recvwindow_start;
-static net_client_recv_t recvwindow[BACKUPTICS][NET_MAXPLAYERS];
+    net_svdemo_t demo;
+};
 
-#define NET_SV_ExpandTicNum(b) NET_ExpandTicNum(recvwindow_start, (b))
+static net_server_t default_server;
+
+// Instance that the NET_SV_ functions currently act on.
+
+static net_server_t *sv = &default_server;
+
+#define NET_SV_ExpandTicNum(b) NET_ExpandTicNum(sv->recvwindow_start, (b))
 
 static void NET_SV_DisconnectClient(net_client_t *client)
 {
@@ -216,9 +237,9 @@ static void NET_SV_BroadcastMessage(const char *s, ...)
 
     for (i=0; i<MAXNETNODES; ++i)
     {
-        if (ClientConnected(&clients[i]))
+        if (ClientConnected(&sv->clients[i]))
         {
-            NET_SV_SendConsoleMessage(&clients[i], "%s", buf);
+            NET_SV_SendConsoleMessage(&sv->clients[i], "%s", buf);
         }
     }
 
@@ -237,24 +258,24 @@ static void NET_SV_AssignPlayers(void)
 
     for (i=0; i<MAXNETNODES; ++i)
     {
-        if (ClientConnected(&clients[i]))
+        if (ClientConnected(&sv->clients[i]))
         {
-            if (!clients[i].drone)
+            if (!sv->clients[i].drone)
             {
-                sv_players[pl] = &clients[i];
-                sv_players[pl]->player_number = pl;
+                sv->players[pl] = &sv->clients[i];
+                sv->players[pl]->player_number = pl;
                 ++pl;
             }
             else
             {
-                clients[i].player_number = -1;
+                sv->clients[i].player_number = -1;
             }
         }
     }
 
     for (; pl<NET_MAXPLAYERS; ++pl)
     {
-        sv_players[pl] = NULL;
+        sv->players[pl] = NULL;
     }
 }
 
@@ -269,7 +290,7 @@ static int NET_SV_NumPlayers(void)
 
     for (i=0; i<NET_MAXPLAYERS; ++i)
     {
-        if (sv_players[i] != NULL && ClientConnected(sv_players[i]))
+        if (sv->players[i] != NULL && ClientConnected(sv->players[i]))
         {
             result += 1;
         }
@@ -287,8 +308,8 @@ static int NET_SV_NumReadyPlayers(void)
 
     for (i = 0; i < MAXNETNODES; ++i)
     {
-        if (ClientConnected(&clients[i])
-         && !clients[i].drone && clients[i].ready)
+        if (ClientConnected(&sv->clients[i])
+         && !sv->clients[i].drone && sv->clients[i].ready)
         {
             ++result;
         }
@@ -305,9 +326,9 @@ static int NET_SV_MaxPlayers(void)
 
     for (i = 0; i < MAXNETNODES; ++i)
     {
-        if (ClientConnected(&clients[i]))
+        if (ClientConnected(&sv->clients[i]))
         {
-            return clients[i].max_players;
+            return sv->clients[i].max_players;
         }
     }
 
@@ -325,7 +346,7 @@ static int NET_SV_NumDrones(void)
 
     for (i=0; i<MAXNETNODES; ++i)
     {
-        if (ClientConnected(&clients[i]) && clients[i].drone)
+        if (ClientConnected(&sv->clients[i]) && sv->clients[i].drone)
         {
             result += 1;
         }
@@ -345,7 +366,7 @@ static int NET_SV_NumClients(void)
 
     for (i=0; i<MAXNETNODES; ++i)
     {
-        if (ClientConnected(&clients[i]))
+        if (ClientConnected(&sv->clients[i]))
         {
             ++count;
         }
@@ -369,14 +390,14 @@ static net_client_t *NET_SV_Controller(void)
     {
         // Can't be controller?
 
-        if (!ClientConnected(&clients[i]) || clients[i].drone)
+        if (!ClientConnected(&sv->clients[i]) || sv->clients[i].drone)
         {
             continue;
         }
 
-        if (best == NULL || clients[i].connect_time < best->connect_time)
+        if (best == NULL || sv->clients[i].connect_time < best->connect_time)
         {
-            best = &clients[i];
+            best = &sv->clients[i];
         }
     }
 
@@ -421,10 +442,10 @@ static void NET_SV_SendWaitingData(net_client_t *client)
     for (i = 0; i < wait_data.num_players; ++i)
     {
         M_StringCopy(wait_data.player_names[i],
-                     sv_players[i]->name,
+                     sv->players[i]->name,
                      MAXPLAYERNAME);
         M_StringCopy(wait_data.player_addrs[i],
-                     NET_AddrToString(sv_players[i]->addr),
+                     NET_AddrToString(sv->players[i]->addr),
                      MAXPLAYERNAME);
     }
 
@@ -450,11 +471,11 @@ static unsigned int NET_SV_LatestAcknowledged(void)
 
     for (i=0; i<MAXNETNODES; ++i) 
     {
-        if (ClientConnected(&clients[i]))
+        if (ClientConnected(&sv->clients[i]))
         {
-            if (clients[i].acknowledged < lowtic)
+            if (sv->clients[i].acknowledged < lowtic)
             {
-                lowtic = clients[i].acknowledged;
+                lowtic = sv->clients[i].acknowledged;
             }
         }
     }
@@ -466,6 +487,38 @@ static unsigned int NET_SV_LatestAcknowledged(void)
 // Possibly advance the recv window if all connected clients have
 // used the data in the window
 
+// Record the first tic in the receive window, which is complete.
+
+static void NET_SV_RecordTic(void)
+{
+    net_full_ticcmd_t cmd;
+    int i;
+
+    if (sv->demo.demo == NULL && sv->demo.stream == NULL)
+    {
+        return;
+    }
+
+    cmd.seq = sv->recvwindow_start;
+    cmd.latency = 0;
+
+    for (i=0; i<NET_MAXPLAYERS; ++i)
+    {
+        cmd.playeringame[i] = sv->players[i] != NULL
+                           && sv->recvwindow[0][i].active;
+
+        if (cmd.playeringame[i])
+        {
+            cmd.cmds[i] = sv->recvwindow[0][i].diff;
+
+            if (sv->recvwindow[0][i].latency > cmd.latency)
+                cmd.latency = sv->recvwindow[0][i].latency;
+        }
+    }
+
+    NET_SVDemo_WriteTic(&sv->demo, &cmd);
+}
+
 static void NET_SV_AdvanceWindow(void)
 {
     unsigned int lowtic;
@@ -480,7 +533,7 @@ static void NET_SV_AdvanceWindow(void)
 
     // Advance the recv window until it catches up with lowtic
 
-    while (recvwindow_start < lowtic)
+    while (sv->recvwindow_start < lowtic)
     {
         boolean should_advance;
 
@@ -491,12 +544,12 @@ static void NET_SV_AdvanceWindow(void)
 
         for (i=0; i<NET_MAXPLAYERS; ++i)
         {
-            if (sv_players[i] == NULL || !ClientConnected(sv_players[i]))
+            if (sv->players[i] == NULL || !ClientConnected(sv->players[i]))
             {
                 continue;
             }
 
-            if (!recvwindow[0][i].active)
+            if (!sv->recvwindow[0][i].active)
             {
                 should_advance = false;
                 break;
@@ -512,13 +565,15 @@ static void NET_SV_AdvanceWindow(void)
             break;
         }
         
+        NET_SV_RecordTic();
+
         // Advance the window
 
-        memmove(recvwindow, recvwindow + 1,
-                sizeof(*recvwindow) * (BACKUPTICS - 1));
-        memset(&recvwindow[BACKUPTICS-1], 0, sizeof(*recvwindow));
-        ++recvwindow_start;
-        NET_Log("server: advanced receive window to %d", recvwindow_start);
+        memmove(sv->recvwindow, sv->recvwindow + 1,
+                sizeof(*sv->recvwindow) * (BACKUPTICS - 1));
+        memset(&sv->recvwindow[BACKUPTICS-1], 0, sizeof(*sv->recvwindow));
+        ++sv->recvwindow_start;
+        NET_Log("server: advanced receive window to %d", sv->recvwindow_start);
     }
 }
 
@@ -530,11 +585,11 @@ static net_client_t *NET_SV_FindClient(net_addr_t *addr)
 
     for (i=0; i<MAXNETNODES; ++i) 
     {
-        if (clients[i].active && clients[i].addr == addr)
+        if (sv->clients[i].active && sv->clients[i].addr == addr)
         {
             // found the client
 
-            return &clients[i];
+            return &sv->clients[i];
         }
     }
 
@@ -675,10 +730,10 @@ static void NET_SV_ParseSYN(net_packet_t *packet, net_client_t *client,
     // At this point we have received a valid SYN.
 
     // Not accepting new connections?
-    if (server_state != SERVER_WAITING_LAUNCH)
+    if (sv->state != SERVER_WAITING_LAUNCH)
     {
         NET_Log("server: error: not in waiting launch state, server_state=%d",
-                server_state);
+                sv->state);
         NET_SV_SendReject(addr,
                           "Server is not currently accepting connections");
         return;
@@ -704,23 +759,23 @@ static void NET_SV_ParseSYN(net_packet_t *packet, net_client_t *client,
     // Adopt the game mode and mission of the first connecting client:
     if (num_players == 0 && !data.drone)
     {
-        sv_gamemode = data.gamemode;
-        sv_gamemission = data.gamemission;
+        sv->gamemode = data.gamemode;
+        sv->gamemission = data.gamemission;
         NET_Log("server: new game, mode=%d, mission=%d",
-                sv_gamemode, sv_gamemission);
+                sv->gamemode, sv->gamemission);
     }
 
     // Check the connecting client is playing the same game as all
     // the other clients
-    if (data.gamemode != sv_gamemode || data.gamemission != sv_gamemission)
+    if (data.gamemode != sv->gamemode || data.gamemission != sv->gamemission)
     {
         char msg[128];
         NET_Log("server: wrong mode/mission, %d != %d || %d != %d",
-                data.gamemode, sv_gamemode, data.gamemission, sv_gamemission);
+                data.gamemode, sv->gamemode, data.gamemission, sv->gamemission);
         M_snprintf(msg, sizeof(msg),
                    "Game mismatch: server is %s (%s), client is %s (%s)",
-                   D_GameMissionString(sv_gamemission),
-                   D_GameModeString(sv_gamemode),
+                   D_GameMissionString(sv->gamemission),
+                   D_GameModeString(sv->gamemode),
                    D_GameMissionString(data.gamemission),
                    D_GameModeString(data.gamemode));
 
@@ -735,9 +790,9 @@ static void NET_SV_ParseSYN(net_packet_t *packet, net_client_t *client,
 
         for (i=0; i<MAXNETNODES; ++i)
         {
-            if (!clients[i].active)
+            if (!sv->clients[i].active)
             {
-                client = &clients[i];
+                client = &sv->clients[i];
                 break;
             }
         }
@@ -807,10 +862,10 @@ static void NET_SV_ParseLaunch(net_packet_t *packet, net_client_t *client)
 
     // Can only launch when we are in the waiting state.
 
-    if (server_state != SERVER_WAITING_LAUNCH)
+    if (sv->state != SERVER_WAITING_LAUNCH)
     {
         NET_Log("server: error: not in waiting launch state, state=%d",
-                server_state);
+                sv->state);
         return;
     }
 
@@ -821,17 +876,17 @@ static void NET_SV_ParseLaunch(net_packet_t *packet, net_client_t *client)
 
     for (i=0; i<MAXNETNODES; ++i)
     {
-        if (!ClientConnected(&clients[i]))
+        if (!ClientConnected(&sv->clients[i]))
             continue;
 
-        launchpacket = NET_Conn_NewReliable(&clients[i].connection,
+        launchpacket = NET_Conn_NewReliable(&sv->clients[i].connection,
                                             NET_PACKET_TYPE_LAUNCH);
         NET_WriteInt8(launchpacket, num_players);
     }
 
     // Now in launch state.
 
-    server_state = SERVER_WAITING_START;
+    sv->state = SERVER_WAITING_START;
 }
 
 // Transition to the in-game state and send all players the start game
@@ -841,6 +896,7 @@ static void NET_SV_ParseLaunch(net_packet_t *packet, net_client_t *client)
 static void StartGame(void)
 {
     net_packet_t *startpacket;
+    boolean playeringame[NET_MAXPLAYERS];
     unsigned int i;
     int nowtime;
 
@@ -850,29 +906,29 @@ static void StartGame(void)
 
     // Check if anyone is recording a demo and set lowres_turn if so.
 
-    sv_settings.lowres_turn = false;
+    sv->settings.lowres_turn = false;
 
     for (i = 0; i < NET_MAXPLAYERS; ++i)
     {
-        if (sv_players[i] != NULL && sv_players[i]->recording_lowres)
+        if (sv->players[i] != NULL && sv->players[i]->recording_lowres)
         {
-            sv_settings.lowres_turn = true;
+            sv->settings.lowres_turn = true;
         }
     }
 
-    sv_settings.num_players = NET_SV_NumPlayers();
+    sv->settings.num_players = NET_SV_NumPlayers();
 
     // Copy player classes:
 
     for (i = 0; i < NET_MAXPLAYERS; ++i)
     {
-        if (sv_players[i] != NULL)
+        if (sv->players[i] != NULL)
         {
-            sv_settings.player_classes[i] = sv_players[i]->player_class;
+            sv->settings.player_classes[i] = sv->players[i]->player_class;
         }
         else
         {
-            sv_settings.player_classes[i] = 0;
+            sv->settings.player_classes[i] = 0;
         }
     }
 
@@ -882,25 +938,33 @@ static void StartGame(void)
 
     for (i = 0; i < MAXNETNODES; ++i)
     {
-        if (!ClientConnected(&clients[i]))
+        if (!ClientConnected(&sv->clients[i]))
             continue;
 
-        clients[i].last_gamedata_time = nowtime;
+        sv->clients[i].last_gamedata_time = nowtime;
 
-        startpacket = NET_Conn_NewReliable(&clients[i].connection,
+        startpacket = NET_Conn_NewReliable(&sv->clients[i].connection,
                                            NET_PACKET_TYPE_GAMESTART);
 
-        sv_settings.consoleplayer = clients[i].player_number;
+        sv->settings.consoleplayer = sv->clients[i].player_number;
 
-        NET_WriteSettings(startpacket, &sv_settings);
+        NET_WriteSettings(startpacket, &sv->settings);
     }
 
     // Change server state
     NET_Log("server: beginning game state");
-    server_state = SERVER_IN_GAME;
+    sv->state = SERVER_IN_GAME;
+
+    memset(sv->recvwindow, 0, sizeof(sv->recvwindow));
+    sv->recvwindow_start = 0;
+
+    for (i = 0; i < NET_MAXPLAYERS; ++i)
+    {
+        playeringame[i] = sv->players[i] != NULL;
+    }
 
-    memset(recvwindow, 0, sizeof(recvwindow));
-    recvwindow_start = 0;
+    NET_SVDemo_Start(&sv->demo, sv->gamemission, sv->gamemode,
+                     &sv->settings, playeringame);
 }
 
 // Returns true when all nodes have indicated readiness to start the game.
@@ -911,7 +975,7 @@ static boolean AllNodesReady(void)
 
     for (i = 0; i < MAXNETNODES; ++i)
     {
-        if (ClientConnected(&clients[i]) && !clients[i].ready)
+        if (ClientConnected(&sv->clients[i]) && !sv->clients[i].ready)
         {
             return false;
         }
@@ -943,9 +1007,9 @@ static void SendAllWaitingData(void)
 
     for (i = 0; i < MAXNETNODES; ++i)
     {
-        if (ClientConnected(&clients[i]) && clients[i].ready)
+        if (ClientConnected(&sv->clients[i]) && sv->clients[i].ready)
         {
-            NET_SV_SendWaitingData(&clients[i]);
+            NET_SV_SendWaitingData(&sv->clients[i]);
         }
     }
 }
@@ -960,10 +1024,10 @@ static void NET_SV_ParseGameStart(net_packet_t *packet, net_client_t *client)
 
     // Can only start a game if we are in the waiting start state.
 
-    if (server_state != SERVER_WAITING_START)
+    if (sv->state != SERVER_WAITING_START)
     {
         NET_Log("server: error: not in waiting start state, server_state=%d",
-                server_state);
+                sv->state);
         return;
     }
 
@@ -978,13 +1042,13 @@ static void NET_SV_ParseGameStart(net_packet_t *packet, net_client_t *client)
 
         // Check the game settings are valid
 
-        if (!NET_ValidGameSettings(sv_gamemode, sv_gamemission, &settings))
+        if (!NET_ValidGameSettings(sv->gamemode, sv->gamemission, &settings))
         {
             NET_Log("server: error: invalid game settings");
             return;
         }
 
-        sv_settings = settings;
+        sv->settings = settings;
     }
 
     client->ready = true;
@@ -1011,6 +1075,8 @@ static void NET_SV_SendResendRequest(net_client_t *client, int start, int end)
     NET_Log("server: send resend to %s for tics %d-%d",
             NET_AddrToString(client->addr), start, end);
 
+    ++sv->stats.resend_requests;
+
     packet = NET_NewPacket(20);
 
     NET_WriteInt16(packet, NET_PACKET_TYPE_GAMEDATA_RESEND);
@@ -1026,7 +1092,7 @@ static void NET_SV_SendResendRequest(net_client_t *client, int start, int end)
 
     for (i=start; i<=end; ++i)
     {
-        index = i - recvwindow_start;
+        index = i - sv->recvwindow_start;
 
         if (index >= BACKUPTICS)
         {
@@ -1035,7 +1101,7 @@ static void NET_SV_SendResendRequest(net_client_t *client, int start, int end)
             continue;
         }
         
-        recvobj = &recvwindow[index][client->player_number];
+        recvobj = &sv->recvwindow[index][client->player_number];
 
         recvobj->resend_time = nowtime;
     }
@@ -1061,7 +1127,7 @@ static void NET_SV_CheckResends(net_client_t *client)
         net_client_recv_t *recvobj;
         boolean need_resend;
 
-        recvobj = &recvwindow[i][player];
+        recvobj = &sv->recvwindow[i][player];
 
         // if need_resend is true, this tic needs another retransmit
         // request (300ms timeout)
@@ -1084,12 +1150,12 @@ static void NET_SV_CheckResends(net_client_t *client)
             // End of a run of resend tics
             NET_Log("server: resend request to %s timed out for %d-%d (%d)",
                     NET_AddrToString(client->addr),
-                    recvwindow_start + resend_start,
-                    recvwindow_start + resend_end,
-                    &recvwindow[resend_start][player].resend_time);
+                    sv->recvwindow_start + resend_start,
+                    sv->recvwindow_start + resend_end,
+                    &sv->recvwindow[resend_start][player].resend_time);
             NET_SV_SendResendRequest(client, 
-                                     recvwindow_start + resend_start,
-                                     recvwindow_start + resend_end);
+                                     sv->recvwindow_start + resend_start,
+                                     sv->recvwindow_start + resend_end);
 
             resend_start = -1;
         }
@@ -1099,12 +1165,12 @@ static void NET_SV_CheckResends(net_client_t *client)
     {
         NET_Log("server: resend request to %s timed out for %d-%d (%d)",
                 NET_AddrToString(client->addr),
-                recvwindow_start + resend_start,
-                recvwindow_start + resend_end,
-                &recvwindow[resend_start][player].resend_time);
+                sv->recvwindow_start + resend_start,
+                sv->recvwindow_start + resend_end,
+                &sv->recvwindow[resend_start][player].resend_time);
         NET_SV_SendResendRequest(client,
-                                 recvwindow_start + resend_start,
-                                 recvwindow_start + resend_end);
+                                 sv->recvwindow_start + resend_start,
+                                 sv->recvwindow_start + resend_end);
     }
 }
 
@@ -1122,10 +1188,10 @@ static void NET_SV_ParseGameData(net_packet_t *packet, net_client_t *client)
     int resend_start, resend_end;
     int index;
 
-    if (server_state != SERVER_IN_GAME)
+    if (sv->state != SERVER_IN_GAME)
     {
         NET_Log("server: error: not in game state: server_state=%d",
-                server_state);
+                sv->state);
         return;
     }
 
@@ -1165,12 +1231,12 @@ static void NET_SV_ParseGameData(net_packet_t *packet, net_client_t *client)
         signed int latency;
 
         if (!NET_ReadSInt16(packet, &latency)
-         || !NET_ReadTiccmdDiff(packet, &diff, sv_settings.lowres_turn))
+         || !NET_ReadTiccmdDiff(packet, &diff, sv->settings.lowres_turn))
         {
             return;
         }
 
-        index = seq + i - recvwindow_start;
+        index = seq + i - sv->recvwindow_start;
 
         if (index < 0 || index >= BACKUPTICS)
         {
@@ -1179,7 +1245,7 @@ static void NET_SV_ParseGameData(net_packet_t *packet, net_client_t *client)
             continue;
         }
 
-        recvobj = &recvwindow[index][player];
+        recvobj = &sv->recvwindow[index][player];
         recvobj->active = true;
         recvobj->diff = diff;
         recvobj->latency = latency;
@@ -1202,7 +1268,7 @@ static void NET_SV_ParseGameData(net_packet_t *packet, net_client_t *client)
 
     //printf("SV: %p: %i\n", client, seq);
 
-    resend_end = seq - recvwindow_start;
+    resend_end = seq - sv->recvwindow_start;
 
     if (resend_end <= 0)
         return;
@@ -1215,7 +1281,7 @@ static void NET_SV_ParseGameData(net_packet_t *packet, net_client_t *client)
     
     while (index >= 0)
     {
-        recvobj = &recvwindow[index][player];
+        recvobj = &sv->recvwindow[index][player];
 
         if (recvobj->active)
         {
@@ -1239,11 +1305,11 @@ static void NET_SV_ParseGameData(net_packet_t *packet, net_client_t *client)
     if (resend_start < resend_end)
     {
         NET_Log("server: request resend for %d-%d before %d",
-                recvwindow_start + resend_start,
-                recvwindow_start + resend_end - 1, seq);
+                sv->recvwindow_start + resend_start,
+                sv->recvwindow_start + resend_end - 1, seq);
         NET_SV_SendResendRequest(client, 
-                                 recvwindow_start + resend_start, 
-                                 recvwindow_start + resend_end - 1);
+                                 sv->recvwindow_start + resend_start, 
+                                 sv->recvwindow_start + resend_end - 1);
     }
 }
 
@@ -1253,10 +1319,10 @@ static void NET_SV_ParseGameDataACK(net_packet_t *packet, net_client_t *client)
 
     NET_Log("server: processing game data ack packet");
 
-    if (server_state != SERVER_IN_GAME)
+    if (sv->state != SERVER_IN_GAME)
     {
         NET_Log("server: error: not in game state, server_state=%d",
-                server_state);
+                sv->state);
         return;
     }
 
@@ -1281,24 +1347,47 @@ static void NET_SV_ParseGameDataACK(net_packet_t *packet, net_client_t *client)
     }
 }
 
-static void NET_SV_SendTics(net_client_t *client, 
-                            unsigned int start, unsigned int end)
+// [crispy] Stop adding tics to a game data packet once it has grown
+// past this many bytes. A tic with full ticcmds for every player takes
+// at most about 130 bytes, so packets stay well inside the 1500 byte
+// buffers that packets are received into.
+
+#define MAX_GAMEDATA_LEN 1200
+
+// Send as many of the tics from start to end as fit in one packet.
+// Returns the number of the last tic sent.
+
+static unsigned int NET_SV_SendTicsPacket(net_client_t *client,
+                                          unsigned int start, unsigned int end)
 {
     net_packet_t *packet;
+    net_packed_tics_t packed;
+    boolean use_packed;
+    unsigned int count_pos;
     unsigned int i;
 
     packet = NET_NewPacket(500);
 
     NET_WriteInt16(packet, NET_PACKET_TYPE_GAMEDATA);
 
-    // Send the start tic and number of tics
+    // Send the start tic and number of tics; the number is filled in
+    // once we know how many fit.
 
     NET_WriteInt8(packet, start & 0xff);
-    NET_WriteInt8(packet, end-start + 1);
+    count_pos = packet->len;
+    NET_WriteInt8(packet, 0);
 
     // Write the tics
 
-    for (i=start; i<=end; ++i)
+    use_packed = client->connection.protocol
+              == NET_PROTOCOL_CRISPY_DOOM_PACKED_TICS;
+
+    if (use_packed)
+    {
+        NET_BeginPackedTics(&packed, packet);
+    }
+
+    for (i=start; ; ++i)
     {
         net_full_ticcmd_t *cmd;
 
@@ -1311,14 +1400,50 @@ static void NET_SV_SendTics(net_client_t *client,
 
         // Add command
        
-        NET_WriteFullTiccmd(packet, cmd, sv_settings.lowres_turn);
+        if (use_packed)
+        {
+            NET_WritePackedTiccmd(&packed, cmd, sv->settings.lowres_turn);
+        }
+        else
+        {
+            NET_WriteFullTiccmd(packet, cmd, sv->settings.lowres_turn);
+        }
+
+        if (i == end || packet->len >= MAX_GAMEDATA_LEN)
+        {
+            break;
+        }
     }
+
+    if (use_packed)
+    {
+        NET_EndPackedTics(&packed);
+    }
+
+    packet->data[count_pos] = i - start + 1;
     
     // Send packet
 
     NET_Conn_SendPacket(&client->connection, packet);
     
     NET_FreePacket(packet);
+
+    return i;
+}
+
+static void NET_SV_SendTics(net_client_t *client, 
+                            unsigned int start, unsigned int end)
+{
+    unsigned int last;
+
+    // [crispy] Runs of many tics, as batched for packed tics clients or
+    // asked for in resend requests, are split over several packets.
+
+    do
+    {
+        last = NET_SV_SendTicsPacket(client, start, end);
+        start = last + 1;
+    } while (last != end);
 }
 
 // Parse a retransmission request from a client
@@ -1367,6 +1492,8 @@ static void NET_SV_ParseResendRequest(net_packet_t *packet, net_client_t *client
     // Resend those tics
     NET_Log("server: resending tics %d-%d", start, last);
     NET_SV_SendTics(client, start, last);
+
+    sv->stats.tics_resent += last - start + 1;
 }
 
 // Send a response back to the client
@@ -1383,7 +1510,7 @@ void NET_SV_SendQueryResponse(net_addr_t *addr)
 
     // Server state
 
-    querydata.server_state = server_state;
+    querydata.server_state = sv->state;
 
     // Number of players/maximum players
 
@@ -1392,8 +1519,8 @@ void NET_SV_SendQueryResponse(net_addr_t *addr)
 
     // Game mode/mission
 
-    querydata.gamemode = sv_gamemode;
-    querydata.gamemission = sv_gamemission;
+    querydata.gamemode = sv->gamemode;
+    querydata.gamemission = sv->gamemission;
 
     //!
     // @category net
@@ -1435,7 +1562,7 @@ static void NET_SV_ParseHolePunch(net_packet_t *packet)
         return;
     }
 
-    addr = NET_ResolveAddress(server_context, addr_string);
+    addr = NET_ResolveAddress(sv->context, addr_string);
     if (addr == NULL)
     {
         NET_Log("server: error: failed to resolve address: %s", addr_string);
@@ -1486,7 +1613,7 @@ static void NET_SV_Packet(net_packet_t *packet, net_addr_t *addr)
 
     // Response from master server?
 
-    if (addr != NULL && addr == master_server)
+    if (addr != NULL && addr == sv->master_server)
     {
         NET_SV_MasterPacket(packet);
         return;
@@ -1554,30 +1681,31 @@ static void NET_SV_Packet(net_packet_t *packet, net_addr_t *addr)
     }
 }
 
+// Generate the next tic for a client into its send queue, if we have
+// the data for it.  Returns true if a tic was generated.
 
-static void NET_SV_PumpSendQueue(net_client_t *client)
+static boolean NET_SV_GenerateTic(net_client_t *client)
 {
     net_full_ticcmd_t cmd;
     int recv_index;
     int num_players;
     int i;
-    int starttic, endtic;
 
     // If a client has not sent any acknowledgments for a while,
     // wait until they catch up.
 
     if (client->sendseq - NET_SV_LatestAcknowledged() > 40)
     {
-        return;
+        return false;
     }
     
     // Work out the index into the receive window
    
-    recv_index = client->sendseq - recvwindow_start;
+    recv_index = client->sendseq - sv->recvwindow_start;
 
     if (recv_index < 0 || recv_index >= BACKUPTICS)
     {
-        return;
+        return false;
     }
 
     // Check if we can generate a new entry for the send queue
@@ -1587,24 +1715,24 @@ static void NET_SV_PumpSendQueue(net_client_t *client)
 
     for (i=0; i<NET_MAXPLAYERS; ++i)
     {
-        if (sv_players[i] == client)
+        if (sv->players[i] == client)
         {
             // Client does not rely on itself for data
 
             continue;
         }
 
-        if (sv_players[i] == NULL || !ClientConnected(sv_players[i]))
+        if (sv->players[i] == NULL || !ClientConnected(sv->players[i]))
         {
             continue;
         }
 
-        if (!recvwindow[recv_index][i].active)
+        if (!sv->recvwindow[recv_index][i].active)
         {
             // We do not have this player's ticcmd, so we cannot
             // generate a complete command yet.
 
-            return;
+            return false;
         }
 
         ++num_players;
@@ -1616,9 +1744,9 @@ static void NET_SV_PumpSendQueue(net_client_t *client)
     // and never stopping. Don't let the server get too far ahead
     // of the client.
 
-    if (num_players == 0 && client->sendseq > recvwindow_start + 10)
+    if (num_players == 0 && client->sendseq > sv->recvwindow_start + 10)
     {
-        return;
+        return false;
     }
 
     // We have all data we need to generate a command for this tic.
@@ -1633,7 +1761,7 @@ static void NET_SV_PumpSendQueue(net_client_t *client)
     {
         net_client_recv_t *recvobj;
 
-        if (sv_players[i] == client)
+        if (sv->players[i] == client)
         {
             // Not the player we are sending to
 
@@ -1641,7 +1769,7 @@ static void NET_SV_PumpSendQueue(net_client_t *client)
             continue;
         }
         
-        if (sv_players[i] == NULL || !recvwindow[recv_index][i].active)
+        if (sv->players[i] == NULL || !sv->recvwindow[recv_index][i].active)
         {
             cmd.playeringame[i] = false;
             continue;
@@ -1649,7 +1777,7 @@ static void NET_SV_PumpSendQueue(net_client_t *client)
 
         cmd.playeringame[i] = true;
 
-        recvobj = &recvwindow[recv_index][i];
+        recvobj = &sv->recvwindow[recv_index][i];
 
         cmd.cmds[i] = recvobj->diff;
 
@@ -1663,10 +1791,37 @@ static void NET_SV_PumpSendQueue(net_client_t *client)
 
     client->sendqueue[client->sendseq % BACKUPTICS] = cmd;
 
-    // Transmit the new tic to the client
+    ++client->sendseq;
+    ++sv->stats.tics_sent;
+
+    return true;
+}
+
+// Generate and send the next tic for a client, if we have the data for
+// it.  Returns true if a tic was sent.
+
+static boolean NET_SV_PumpSendQueue(net_client_t *client)
+{
+    int starttic, endtic;
 
-    starttic = client->sendseq - sv_settings.extratics;
-    endtic = client->sendseq;
+    starttic = client->sendseq - sv->settings.extratics;
+
+    if (!NET_SV_GenerateTic(client))
+    {
+        return false;
+    }
+
+    // [crispy] Clients that understand packed tics get every tic that
+    // is ready in one packet, rather than one packet per tic.
+
+    if (client->connection.protocol == NET_PROTOCOL_CRISPY_DOOM_PACKED_TICS)
+    {
+        while (NET_SV_GenerateTic(client));
+    }
+
+    // Transmit the new tics to the client
+
+    endtic = client->sendseq - 1;
 
     if (starttic < 0)
         starttic = 0;
@@ -1675,7 +1830,7 @@ static void NET_SV_PumpSendQueue(net_client_t *client)
             NET_AddrToString(client->addr));
     NET_SV_SendTics(client, starttic, endtic);
 
-    ++client->sendseq;
+    return true;
 }
 
 // Prevent against deadlock: resend requests are usually only
@@ -1712,16 +1867,16 @@ void NET_SV_CheckDeadlock(net_client_t *client)
 
         for (i=0; i<BACKUPTICS; ++i)
         {
-            if (!recvwindow[i][client->player_number].active)
+            if (!sv->recvwindow[i][client->player_number].active)
             {
                 NET_Log("server: deadlock: sending resend request for %d-%d",
-                        recvwindow_start + i, recvwindow_start + i + 5);
+                        sv->recvwindow_start + i, sv->recvwindow_start + i + 5);
 
                 // Found a tic we haven't received.  Send a resend request.
 
                 NET_SV_SendResendRequest(client,
-                                         recvwindow_start + i,
-                                         recvwindow_start + i + 5);
+                                         sv->recvwindow_start + i,
+                                         sv->recvwindow_start + i + 5);
 
                 client->last_gamedata_time = nowtime;
                 break;
@@ -1749,14 +1904,16 @@ static void NET_SV_GameEnded(void)
 {
     int i;
 
-    server_state = SERVER_WAITING_LAUNCH;
-    sv_gamemode = indetermined;
+    NET_SVDemo_Stop(&sv->demo);
+
+    sv->state = SERVER_WAITING_LAUNCH;
+    sv->gamemode = indetermined;
 
     for (i=0; i<MAXNETNODES; ++i)
     {
-        if (clients[i].active)
+        if (sv->clients[i].active)
         {
-            NET_SV_DisconnectClient(&clients[i]);
+            NET_SV_DisconnectClient(&sv->clients[i]);
         }
     }
 }
@@ -1787,7 +1944,7 @@ static void NET_SV_RunClient(net_client_t *client)
         // If we were about to start a game, any player disconnecting
         // should cause an abort.
 
-        if (server_state == SERVER_WAITING_START && !client->drone)
+        if (sv->state == SERVER_WAITING_START && !client->drone)
         {
             NET_SV_BroadcastMessage("Game startup aborted because "
                                     "player '%s' disconnected.",
@@ -1817,7 +1974,7 @@ static void NET_SV_RunClient(net_client_t *client)
         return;
     }
 
-    if (server_state == SERVER_WAITING_LAUNCH)
+    if (sv->state == SERVER_WAITING_LAUNCH)
     {
         // Waiting for the game to start
 
@@ -1831,9 +1988,15 @@ static void NET_SV_RunClient(net_client_t *client)
         }
     }
 
-    if (server_state == SERVER_IN_GAME)
+    if (sv->state == SERVER_IN_GAME)
     {
-        NET_SV_PumpSendQueue(client);
+        // There may be more tics ready to go out; run again promptly.
+
+        if (NET_SV_PumpSendQueue(client))
+        {
+            sv->work_pending = true;
+        }
+
         NET_SV_CheckDeadlock(client);
     }
 }
@@ -1843,7 +2006,27 @@ static void NET_SV_RunClient(net_client_t *client)
 void NET_SV_AddModule(net_module_t *module)
 {
     module->InitServer();
-    NET_AddModule(server_context, module);
+    NET_AddModule(sv->context, module);
+}
+
+// Allocate a new, independent server instance.  It must be selected with
+// NET_SV_SetInstance and set up with NET_SV_Init before use.
+
+net_server_t *NET_SV_NewInstance(void)
+{
+    net_server_t *server;
+
+    server = Z_Malloc(sizeof(net_server_t), PU_STATIC, 0);
+    memset(server, 0, sizeof(net_server_t));
+
+    return server;
+}
+
+// Select the server instance that the other NET_SV_ functions act on.
+
+void NET_SV_SetInstance(net_server_t *server)
+{
+    sv = server;
 }
 
 // Initialize server and wait for connections
@@ -1854,20 +2037,22 @@ void NET_SV_Init(void)
 
     // initialize send/receive context
 
-    server_context = NET_NewContext();
+    sv->context = NET_NewContext();
 
     // no clients yet
    
     for (i=0; i<MAXNETNODES; ++i) 
     {
-        clients[i].active = false;
+        sv->clients[i].active = false;
     }
 
     NET_SV_AssignPlayers();
 
-    server_state = SERVER_WAITING_LAUNCH;
-    sv_gamemode = indetermined;
-    server_initialized = true;
+    NET_SVDemo_Stop(&sv->demo);
+
+    sv->state = SERVER_WAITING_LAUNCH;
+    sv->gamemode = indetermined;
+    sv->initialized = true;
 }
 
 static void UpdateMasterServer(void)
@@ -1879,23 +2064,23 @@ static void UpdateMasterServer(void)
     // The address of the master server can change. Periodically
     // re-resolve the master server to update.
 
-    if (now - master_resolve_time > MASTER_RESOLVE_PERIOD * 1000)
+    if (now - sv->master_resolve_time > MASTER_RESOLVE_PERIOD * 1000)
     {
         net_addr_t *new_addr;
 
-        new_addr = NET_Query_ResolveMaster(server_context);
-        NET_ReleaseAddress(master_server);
-        master_server = new_addr;
+        new_addr = NET_Query_ResolveMaster(sv->context);
+        NET_ReleaseAddress(sv->master_server);
+        sv->master_server = new_addr;
 
-        master_resolve_time = now;
+        sv->master_resolve_time = now;
     }
 
     // Possibly refresh our registration with the master server.
 
-    if (now - master_refresh_time > MASTER_REFRESH_PERIOD * 1000)
+    if (now - sv->master_refresh_time > MASTER_REFRESH_PERIOD * 1000)
     {
-        NET_Query_AddToMaster(master_server);
-        master_refresh_time = now;
+        NET_Query_AddToMaster(sv->master_server);
+        sv->master_refresh_time = now;
     }
 }
 
@@ -1910,20 +2095,20 @@ void NET_SV_RegisterWithMaster(void)
 
     if (!M_CheckParm("-privateserver"))
     {
-        master_server = NET_Query_ResolveMaster(server_context);
+        sv->master_server = NET_Query_ResolveMaster(sv->context);
     }
     else
     {
-        master_server = NULL;
+        sv->master_server = NULL;
     }
 
     // Send request.
 
-    if (master_server != NULL)
+    if (sv->master_server != NULL)
     {
-        NET_Query_AddToMaster(master_server);
-        master_refresh_time = I_GetTimeMS();
-        master_resolve_time = master_refresh_time;
+        NET_Query_AddToMaster(sv->master_server);
+        sv->master_refresh_time = I_GetTimeMS();
+        sv->master_resolve_time = sv->master_refresh_time;
     }
 }
 
@@ -1936,19 +2121,21 @@ void NET_SV_Run(void)
     net_packet_t *packet;
     int i;
 
-    if (!server_initialized)
+    if (!sv->initialized)
     {
         return;
     }
 
-    while (NET_RecvPacket(server_context, &addr, &packet))
+    sv->work_pending = false;
+
+    while (NET_RecvPacket(sv->context, &addr, &packet))
     {
         NET_SV_Packet(packet, addr);
         NET_FreePacket(packet);
         NET_ReleaseAddress(addr);
     }
 
-    if (master_server != NULL)
+    if (sv->master_server != NULL)
     {
         UpdateMasterServer();
     }
@@ -1958,13 +2145,13 @@ void NET_SV_Run(void)
 
     for (i=0; i<MAXNETNODES; ++i)
     {
-        if (clients[i].active)
+        if (sv->clients[i].active)
         {
-            NET_SV_RunClient(&clients[i]);
+            NET_SV_RunClient(&sv->clients[i]);
         }
     }
 
-    switch (server_state)
+    switch (sv->state)
     {
         case SERVER_WAITING_LAUNCH:
             break;
@@ -1978,22 +2165,136 @@ void NET_SV_Run(void)
 
             for (i = 0; i < NET_MAXPLAYERS; ++i)
             {
-                if (sv_players[i] != NULL && ClientConnected(sv_players[i]))
+                if (sv->players[i] != NULL && ClientConnected(sv->players[i]))
                 {
-                    NET_SV_CheckResends(sv_players[i]);
+                    NET_SV_CheckResends(sv->players[i]);
                 }
             }
             break;
     }
 }
 
+// Returns how long NET_SV_Run can go uncalled, if no packets arrive,
+// before it has something to do.  The result is capped at wait_ms.
+
+int NET_SV_TimeToNextEvent(int wait_ms)
+{
+    net_client_t *client;
+    int nowtime;
+    int i, j;
+
+    if (!sv->initialized)
+    {
+        return wait_ms;
+    }
+
+    if (sv->work_pending)
+    {
+        return 0;
+    }
+
+    nowtime = I_GetTimeMS();
+
+    if (sv->master_server != NULL)
+    {
+        wait_ms = NET_WaitUntil(wait_ms, nowtime, sv->master_refresh_time
+                                + MASTER_REFRESH_PERIOD * 1000);
+        wait_ms = NET_WaitUntil(wait_ms, nowtime, sv->master_resolve_time
+                                + MASTER_RESOLVE_PERIOD * 1000);
+    }
+
+    for (i=0; i<MAXNETNODES; ++i)
+    {
+        client = &sv->clients[i];
+
+        if (!client->active)
+        {
+            continue;
+        }
+
+        wait_ms = NET_Conn_TimeToNextEvent(&client->connection, wait_ms);
+
+        if (!ClientConnected(client))
+        {
+            continue;
+        }
+
+        // Waiting data is sent once a second, see NET_SV_RunClient.
+
+        if (sv->state == SERVER_WAITING_LAUNCH)
+        {
+            if (client->last_send_time < 0)
+            {
+                return 0;
+            }
+
+            wait_ms = NET_WaitUntil(wait_ms, nowtime,
+                                    client->last_send_time + 1000);
+        }
+
+        // Deadlock check, see NET_SV_CheckDeadlock. It only acts, and
+        // moves last_gamedata_time on, when a tic from this player is
+        // missing from the receive window; until then the deadline can
+        // stay in the past, and the window only moves when data arrives.
+
+        if (sv->state == SERVER_IN_GAME && !client->drone)
+        {
+            for (j=0; j<BACKUPTICS; ++j)
+            {
+                if (!sv->recvwindow[j][client->player_number].active)
+                {
+                    wait_ms = NET_WaitUntil(wait_ms, nowtime,
+                                            client->last_gamedata_time
+                                            + 1000);
+                    break;
+                }
+            }
+        }
+    }
+
+    // Expiry of resend requests, see NET_SV_CheckResends.
+
+    if (sv->state == SERVER_IN_GAME)
+    {
+        for (i = 0; i < NET_MAXPLAYERS; ++i)
+        {
+            if (sv->players[i] == NULL || !ClientConnected(sv->players[i]))
+            {
+                continue;
+            }
+
+            for (j=0; j<BACKUPTICS; ++j)
+            {
+                net_client_recv_t *recvobj;
+
+                recvobj = &sv->recvwindow[j][i];
+
+                if (!recvobj->active && recvobj->resend_time != 0)
+                {
+                    wait_ms = NET_WaitUntil(wait_ms, nowtime,
+                                            recvobj->resend_time + 300);
+                }
+            }
+        }
+    }
+
+    return wait_ms;
+}
+
+// Read the traffic counters for the current instance.
+
+void NET_SV_GetStats(net_server_stats_t *stats)
+{
+    *stats = sv->stats;
+}
+
 void NET_SV_Shutdown(void)
 {
     int i;
     boolean running;
     int start_time;
 
-    if (!server_initialized)
+    if (!sv->initialized)
     {
         return;
     }
@@ -2004,9 +2305,9 @@ void NET_SV_Shutdown(void)
     
     for (i=0; i<MAXNETNODES; ++i)
     {
-        if (clients[i].active)
+        if (sv->clients[i].active)
         {
-            NET_SV_DisconnectClient(&clients[i]);
+            NET_SV_DisconnectClient(&sv->clients[i]);
         }
     }
 
@@ -2023,7 +2324,7 @@ void NET_SV_Shutdown(void)
 
         for (i=0; i<MAXNETNODES; ++i)
         {
-            if (clients[i].active)
+            if (sv->clients[i].active)
             {
                 running = true;
             }
@@ -2046,4 +2347,6 @@ void NET_SV_Shutdown(void)
 
         I_Sleep(1);
     }
+
+    NET_SVDemo_Stop(&sv->demo);
 }
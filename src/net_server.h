@@ -17,6 +17,29 @@
 #ifndef NET_SERVER_H
 #define NET_SERVER_H
 
+typedef struct net_server_s net_server_t;
+
+typedef struct
+{
+    // New tics generated and sent to clients.
+
+    unsigned int tics_sent;
+
+    // Resend requests sent to clients for tics we did not receive.
+
+    unsigned int resend_requests;
+
+    // Tics sent again because a client asked for them.
+
+    unsigned int tics_resent;
+} net_server_stats_t;
+
+// Create an extra server instance, and select the current instance.
+// All other NET_SV_ functions act on the current instance.
+
+net_server_t *NET_SV_NewInstance(void);
+void NET_SV_SetInstance(net_server_t *server);
+
 // initialize server and wait for connections
 
 void NET_SV_Init(void);
@@ -25,6 +48,14 @@ void NET_SV_Init(void);
 
 void NET_SV_Run(void);
 
+// How long until the server next needs to run, if no packets arrive.
+
+int NET_SV_TimeToNextEvent(int wait_ms);
+
+// Traffic counters, for benchmarking.
+
+void NET_SV_GetStats(net_server_stats_t *stats);
+
 // Shut down the server
 // Blocks until all clients disconnect, or until a 5 second timeout
 
@@ -32,6 +32,7 @@ static struct
     const char *name;
 } protocol_names[] = {
     {NET_PROTOCOL_CHOCOLATE_DOOM_0, "CHOCOLATE_DOOM_0"},
+    {NET_PROTOCOL_CRISPY_DOOM_PACKED_TICS, "CRISPY_DOOM_PACKED_TICS"},
 };
 
 void NET_WriteConnectData(net_packet_t *packet, net_connect_data_t *data)
@@ -457,6 +458,406 @@ void NET_WriteFullTiccmd(net_packet_t *packet, net_full_ticcmd_t *cmd, boolean l
     }
 }
 
+// [crispy] Packed ticcmds, for NET_PROTOCOL_CRISPY_DOOM_PACKED_TICS.
+// A run of full ticcmds is written as a bit stream.  Latency and the
+// set of players in game are only sent when they change from the
+// previous tic, a tic where nobody changed anything costs a single
+// bit, and movement and turning are sent as the difference from the
+// same player's last value, which is usually small.
+
+void NET_BeginPackedTics(net_packed_tics_t *packed, net_packet_t *packet)
+{
+    memset(packed, 0, sizeof(*packed));
+    packed->packet = packet;
+}
+
+static void WriteBits(net_packed_tics_t *packed, unsigned int value, int bits)
+{
+    while (bits > 0)
+    {
+        --bits;
+        packed->bits = (packed->bits << 1) | ((value >> bits) & 1);
+        ++packed->num_bits;
+
+        if (packed->num_bits == 8)
+        {
+            NET_WriteInt8(packed->packet, packed->bits);
+            packed->bits = 0;
+            packed->num_bits = 0;
+        }
+    }
+}
+
+static boolean ReadBits(net_packed_tics_t *packed, unsigned int *value, int bits)
+{
+    *value = 0;
+
+    while (bits > 0)
+    {
+        if (packed->num_bits == 0)
+        {
+            if (!NET_ReadInt8(packed->packet, &packed->bits))
+            {
+                return false;
+            }
+
+            packed->num_bits = 8;
+        }
+
+        --packed->num_bits;
+        *value = (*value << 1) | ((packed->bits >> packed->num_bits) & 1);
+        --bits;
+    }
+
+    return true;
+}
+
+// Small signed deltas: zigzag encoded, then sent in 4, 8 or 16 bits
+// behind a one or two bit prefix.
+
+static void WriteDelta(net_packed_tics_t *packed, int delta)
+{
+    unsigned int zigzag;
+
+    zigzag = delta < 0 ? ((unsigned int) -delta << 1) - 1
+                       : (unsigned int) delta << 1;
+
+    if (zigzag < 16)
+    {
+        WriteBits(packed, 0, 1);
+        WriteBits(packed, zigzag, 4);
+    }
+    else if (zigzag < 256)
+    {
+        WriteBits(packed, 2, 2);
+        WriteBits(packed, zigzag, 8);
+    }
+    else
+    {
+        WriteBits(packed, 3, 2);
+        WriteBits(packed, zigzag, 16);
+    }
+}
+
+static boolean ReadDelta(net_packed_tics_t *packed, int *delta)
+{
+    unsigned int prefix, zigzag;
+
+    if (!ReadBits(packed, &prefix, 1))
+        return false;
+
+    if (prefix == 0)
+    {
+        if (!ReadBits(packed, &zigzag, 4))
+            return false;
+    }
+    else
+    {
+        if (!ReadBits(packed, &prefix, 1)
+         || !ReadBits(packed, &zigzag, prefix ? 16 : 8))
+            return false;
+    }
+
+    *delta = (zigzag & 1) ? -(int) ((zigzag + 1) >> 1) : (int) (zigzag >> 1);
+
+    return true;
+}
+
+static void WritePackedDiff(net_packed_tics_t *packed, ticcmd_t *last,
+                            net_ticdiff_t *diff, boolean lowres_turn)
+{
+    ticcmd_t *cmd = &diff->cmd;
+
+    WriteBits(packed, diff->diff, 8);
+
+    if (diff->diff & NET_TICDIFF_FORWARD)
+    {
+        WriteDelta(packed, (signed char) (cmd->forwardmove - last->forwardmove));
+        last->forwardmove = cmd->forwardmove;
+    }
+    if (diff->diff & NET_TICDIFF_SIDE)
+    {
+        WriteDelta(packed, (signed char) (cmd->sidemove - last->sidemove));
+        last->sidemove = cmd->sidemove;
+    }
+    if (diff->diff & NET_TICDIFF_TURN)
+    {
+        if (lowres_turn)
+        {
+            WriteDelta(packed, (signed char) (cmd->angleturn / 256
+                                            - last->angleturn / 256));
+        }
+        else
+        {
+            WriteDelta(packed, (short) (cmd->angleturn - last->angleturn));
+        }
+        last->angleturn = cmd->angleturn;
+    }
+    if (diff->diff & NET_TICDIFF_BUTTONS)
+        WriteBits(packed, cmd->buttons, 8);
+    if (diff->diff & NET_TICDIFF_CONSISTANCY)
+        WriteBits(packed, cmd->consistancy, 8);
+    if (diff->diff & NET_TICDIFF_CHATCHAR)
+        WriteBits(packed, cmd->chatchar, 8);
+    if (diff->diff & NET_TICDIFF_RAVEN)
+    {
+        WriteBits(packed, cmd->lookfly, 8);
+        WriteBits(packed, cmd->arti, 8);
+    }
+    if (diff->diff & NET_TICDIFF_STRIFE)
+    {
+        WriteBits(packed, cmd->buttons2, 8);
+        WriteBits(packed, cmd->inventory, 16);
+    }
+}
+
+static boolean ReadPackedDiff(net_packed_tics_t *packed, ticcmd_t *last,
+                              net_ticdiff_t *diff, boolean lowres_turn)
+{
+    ticcmd_t *cmd = &diff->cmd;
+    unsigned int val;
+    int delta;
+
+    if (!ReadBits(packed, &diff->diff, 8))
+        return false;
+
+    if (diff->diff & NET_TICDIFF_FORWARD)
+    {
+        if (!ReadDelta(packed, &delta))
+            return false;
+        last->forwardmove = (signed char) (last->forwardmove + delta);
+        cmd->forwardmove = last->forwardmove;
+    }
+    if (diff->diff & NET_TICDIFF_SIDE)
+    {
+        if (!ReadDelta(packed, &delta))
+            return false;
+        last->sidemove = (signed char) (last->sidemove + delta);
+        cmd->sidemove = last->sidemove;
+    }
+    if (diff->diff & NET_TICDIFF_TURN)
+    {
+        if (!ReadDelta(packed, &delta))
+            return false;
+        if (lowres_turn)
+        {
+            last->angleturn = (signed char) (last->angleturn / 256 + delta)
+                            * 256;
+        }
+        else
+        {
+            last->angleturn = (short) (last->angleturn + delta);
+        }
+        cmd->angleturn = last->angleturn;
+    }
+    if (diff->diff & NET_TICDIFF_BUTTONS)
+    {
+        if (!ReadBits(packed, &val, 8))
+            return false;
+        cmd->buttons = val;
+    }
+    if (diff->diff & NET_TICDIFF_CONSISTANCY)
+    {
+        if (!ReadBits(packed, &val, 8))
+            return false;
+        cmd->consistancy = val;
+    }
+    if (diff->diff & NET_TICDIFF_CHATCHAR)
+    {
+        if (!ReadBits(packed, &val, 8))
+            return false;
+        cmd->chatchar = val;
+    }
+    if (diff->diff & NET_TICDIFF_RAVEN)
+    {
+        if (!ReadBits(packed, &val, 8))
+            return false;
+        cmd->lookfly = val;
+        if (!ReadBits(packed, &val, 8))
+            return false;
+        cmd->arti = val;
+    }
+    if (diff->diff & NET_TICDIFF_STRIFE)
+    {
+        if (!ReadBits(packed, &val, 8))
+            return false;
+        cmd->buttons2 = val;
+        if (!ReadBits(packed, &val, 16))
+            return false;
+        cmd->inventory = val;
+    }
+
+    return true;
+}
+
+void NET_WritePackedTiccmd(net_packed_tics_t *packed, net_full_ticcmd_t *cmd,
+                           boolean lowres_turn)
+{
+    boolean same_players, idle;
+    unsigned int bitfield;
+    int i;
+
+    // Latency
+
+    if (cmd->latency == packed->latency)
+    {
+        WriteBits(packed, 1, 1);
+    }
+    else
+    {
+        WriteBits(packed, 0, 1);
+        WriteBits(packed, cmd->latency & 0xffff, 16);
+        packed->latency = cmd->latency;
+    }
+
+    // Players in game
+
+    same_players = true;
+    idle = true;
+    bitfield = 0;
+
+    for (i=0; i<NET_MAXPLAYERS; ++i)
+    {
+        if (cmd->playeringame[i] != packed->playeringame[i])
+        {
+            same_players = false;
+        }
+
+        if (cmd->playeringame[i])
+        {
+            bitfield |= 1 << i;
+
+            if (cmd->cmds[i].diff != 0)
+            {
+                idle = false;
+            }
+        }
+
+        packed->playeringame[i] = cmd->playeringame[i];
+    }
+
+    if (same_players)
+    {
+        WriteBits(packed, 1, 1);
+    }
+    else
+    {
+        WriteBits(packed, 0, 1);
+        WriteBits(packed, bitfield, NET_MAXPLAYERS);
+    }
+
+    // Player ticcmds: one bit for the whole tic if nobody changed
+    // anything, otherwise one bit for each player that did not.
+
+    WriteBits(packed, idle, 1);
+
+    if (idle)
+    {
+        return;
+    }
+
+    for (i=0; i<NET_MAXPLAYERS; ++i)
+    {
+        if (!cmd->playeringame[i])
+        {
+            continue;
+        }
+
+        if (cmd->cmds[i].diff == 0)
+        {
+            WriteBits(packed, 0, 1);
+        }
+        else
+        {
+            WriteBits(packed, 1, 1);
+            WritePackedDiff(packed, &packed->last[i], &cmd->cmds[i],
+                            lowres_turn);
+        }
+    }
+}
+
+boolean NET_ReadPackedTiccmd(net_packed_tics_t *packed, net_full_ticcmd_t *cmd,
+                             boolean lowres_turn)
+{
+    unsigned int val;
+    int i;
+
+    // Latency
+
+    if (!ReadBits(packed, &val, 1))
+        return false;
+
+    if (!val)
+    {
+        if (!ReadBits(packed, &val, 16))
+            return false;
+        packed->latency = (short) val;
+    }
+
+    cmd->latency = packed->latency;
+
+    // Players in game
+
+    if (!ReadBits(packed, &val, 1))
+        return false;
+
+    if (!val)
+    {
+        if (!ReadBits(packed, &val, NET_MAXPLAYERS))
+            return false;
+
+        for (i=0; i<NET_MAXPLAYERS; ++i)
+        {
+            packed->playeringame[i] = (val & (1 << i)) != 0;
+        }
+    }
+
+    // Player ticcmds
+
+    if (!ReadBits(packed, &val, 1))
+        return false;
+
+    for (i=0; i<NET_MAXPLAYERS; ++i)
+    {
+        cmd->playeringame[i] = packed->playeringame[i];
+        cmd->cmds[i].diff = 0;
+    }
+
+    if (val)
+    {
+        return true;
+    }
+
+    for (i=0; i<NET_MAXPLAYERS; ++i)
+    {
+        if (!cmd->playeringame[i])
+        {
+            continue;
+        }
+
+        if (!ReadBits(packed, &val, 1))
+            return false;
+
+        if (val && !ReadPackedDiff(packed, &packed->last[i], &cmd->cmds[i],
+                                   lowres_turn))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Flush any bits left over after the last packed ticcmd.
+
+void NET_EndPackedTics(net_packed_tics_t *packed)
+{
+    if (packed->num_bits > 0)
+    {
+        WriteBits(packed, 0, 8 - packed->num_bits);
+    }
+}
+
 void NET_WriteWaitData(net_packet_t *packet, net_waitdata_t *data)
 {
     int i;
@@ -37,6 +37,25 @@ extern void NET_TiccmdPatch(ticcmd_t *src, net_ticdiff_t *diff, ticcmd_t *dest);
 boolean NET_ReadFullTiccmd(net_packet_t *packet, net_full_ticcmd_t *cmd, boolean lowres_turn);
 void NET_WriteFullTiccmd(net_packet_t *packet, net_full_ticcmd_t *cmd, boolean lowres_turn);
 
+// [crispy] Bit-packed runs of full ticcmds; the state carries values
+// from one tic to the next, so a run must be read in the order it was
+// written.
+
+typedef struct
+{
+    net_packet_t *packet;
+    unsigned int bits;
+    int num_bits;
+    signed int latency;
+    boolean playeringame[NET_MAXPLAYERS];
+    ticcmd_t last[NET_MAXPLAYERS];
+} net_packed_tics_t;
+
+void NET_BeginPackedTics(net_packed_tics_t *packed, net_packet_t *packet);
+void NET_WritePackedTiccmd(net_packed_tics_t *packed, net_full_ticcmd_t *cmd, boolean lowres_turn);
+boolean NET_ReadPackedTiccmd(net_packed_tics_t *packed, net_full_ticcmd_t *cmd, boolean lowres_turn);
+void NET_EndPackedTics(net_packed_tics_t *packed);
+
 boolean NET_ReadSHA1Sum(net_packet_t *packet, sha1_digest_t digest);
 void NET_WriteSHA1Sum(net_packet_t *packet, sha1_digest_t digest);
 
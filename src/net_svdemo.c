@@ -0,0 +1,361 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// Server-side demo recording.  The server sees every player's ticcmds,
+// so it can record a whole match without any of the clients doing so.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "doomtype.h"
+#include "d_event.h"
+#include "d_mode.h"
+#include "m_argv.h"
+#include "m_misc.h"
+#include "z_zone.h"
+
+#include "net_defs.h"
+#include "net_packet.h"
+#include "net_structrw.h"
+#include "net_svdemo.h"
+
+// Vanilla demos only have room for four players.
+
+#define DEMO_MAXPLAYERS 4
+
+#define DOOM_191_VERSION 111
+#define DEMOMARKER 0x80
+
+// Opens a new file named after the given command line parameter, with
+// a number added if one by that name already exists, so that each
+// match gets its own recording.
+
+static FILE *OpenRecordFile(const char *parm, const char *ext)
+{
+    char *filename;
+    FILE *fstream;
+    int p, i;
+
+    p = M_CheckParmWithArgs(parm, 1);
+
+    if (p == 0)
+    {
+        return NULL;
+    }
+
+    filename = M_StringJoin(myargv[p + 1], ext, NULL);
+
+    for (i = 1; M_FileExists(filename); ++i)
+    {
+        char suffix[16];
+
+        free(filename);
+        M_snprintf(suffix, sizeof(suffix), "-%d", i);
+        filename = M_StringJoin(myargv[p + 1], suffix, ext, NULL);
+    }
+
+    fstream = M_fopen(filename, "wb");
+
+    if (fstream == NULL)
+    {
+        fprintf(stderr, "SV: Failed to open %s for writing\n", filename);
+    }
+    else
+    {
+        fprintf(stderr, "SV: Recording to %s\n", filename);
+    }
+
+    free(filename);
+
+    return fstream;
+}
+
+static int VanillaVersionCode(int gameversion)
+{
+    switch (gameversion)
+    {
+        case exe_doom_1_666:
+            return 106;
+        case exe_doom_1_7:
+            return 107;
+        case exe_doom_1_8:
+            return 108;
+        case exe_doom_1_9:
+        default:  // All other versions are variants on v1.9:
+            return 109;
+    }
+}
+
+// Writes a header in the format G_BeginRecording uses.  Returns false
+// if this game cannot be recorded as a vanilla demo.
+
+static boolean WriteDemoHeader(net_svdemo_t *demo, GameMission_t mission,
+                               net_gamesettings_t *settings,
+                               boolean *playeringame)
+{
+    byte header[13];
+    int len = 0;
+    int i;
+
+    if (mission != doom && mission != doom2 && mission != pack_tnt
+     && mission != pack_plut && mission != pack_chex && mission != pack_hacx
+     && mission != doom2f && mission != pack_nerve && mission != pack_master)
+    {
+        fprintf(stderr, "SV: Demos can only be recorded for Doom games\n");
+        return false;
+    }
+
+    for (i = DEMO_MAXPLAYERS; i < NET_MAXPLAYERS; ++i)
+    {
+        if (playeringame[i])
+        {
+            fprintf(stderr, "SV: Too many players to record a demo\n");
+            return false;
+        }
+    }
+
+    // The clients only send turning in full resolution if none of them
+    // is recording a demo; in that case record a "Doom 1.91" demo.
+
+    demo->longtics = !settings->lowres_turn;
+
+    if (demo->longtics)
+    {
+        header[len++] = DOOM_191_VERSION;
+    }
+    else if (settings->gameversion > exe_doom_1_2)
+    {
+        header[len++] = VanillaVersionCode(settings->gameversion);
+    }
+
+    header[len++] = settings->skill;
+    header[len++] = settings->episode;
+    header[len++] = settings->map;
+
+    if (demo->longtics || settings->gameversion > exe_doom_1_2)
+    {
+        header[len++] = settings->deathmatch;
+        header[len++] = settings->respawn_monsters;
+        header[len++] = settings->fast_monsters;
+        header[len++] = settings->nomonsters;
+        header[len++] = 0;  // consoleplayer
+    }
+
+    for (i = 0; i < DEMO_MAXPLAYERS; ++i)
+    {
+        demo->demo_playeringame[i] = playeringame[i];
+        header[len++] = playeringame[i];
+    }
+
+    return fwrite(header, 1, len, demo->demo) == (size_t) len;
+}
+
+static void WriteDemoTic(net_svdemo_t *demo)
+{
+    byte buf[DEMO_MAXPLAYERS * 5];
+    ticcmd_t cmd;
+    int len = 0;
+    int i, t;
+
+    // The game runs each ticcmd ticdup times, like TicdupSquash does.
+
+    for (t = 0; t < demo->ticdup; ++t)
+    {
+        len = 0;
+
+        for (i = 0; i < DEMO_MAXPLAYERS; ++i)
+        {
+            if (!demo->demo_playeringame[i])
+            {
+                continue;
+            }
+
+            cmd = demo->cmds[i];
+
+            if (t > 0)
+            {
+                cmd.chatchar = 0;
+                if (cmd.buttons & BT_SPECIAL)
+                    cmd.buttons = 0;
+            }
+
+            buf[len++] = cmd.forwardmove;
+            buf[len++] = cmd.sidemove;
+
+            if (demo->longtics)
+            {
+                buf[len++] = cmd.angleturn & 0xff;
+                buf[len++] = (cmd.angleturn >> 8) & 0xff;
+            }
+            else
+            {
+                buf[len++] = cmd.angleturn >> 8;
+            }
+
+            buf[len++] = cmd.buttons;
+        }
+
+        fwrite(buf, 1, len, demo->demo);
+    }
+}
+
+// Ends the vanilla demo, if one is being recorded.
+
+static void EndDemo(net_svdemo_t *demo)
+{
+    byte marker = DEMOMARKER;
+
+    if (demo->demo != NULL)
+    {
+        fwrite(&marker, 1, 1, demo->demo);
+        fclose(demo->demo);
+        demo->demo = NULL;
+    }
+}
+
+static void WriteStreamRecord(net_svdemo_t *demo, net_svstream_record_t type,
+                              net_packet_t *payload)
+{
+    byte header[3];
+    size_t len;
+
+    len = payload != NULL ? payload->len : 0;
+
+    header[0] = ((len + 1) >> 8) & 0xff;
+    header[1] = (len + 1) & 0xff;
+    header[2] = type;
+
+    fwrite(header, 1, sizeof(header), demo->stream);
+
+    if (len > 0)
+    {
+        fwrite(payload->data, 1, len, demo->stream);
+    }
+
+    fflush(demo->stream);
+}
+
+void NET_SVDemo_Start(net_svdemo_t *demo, GameMission_t mission,
+                      GameMode_t mode, net_gamesettings_t *settings,
+                      boolean *playeringame)
+{
+    net_packet_t *packet;
+
+    NET_SVDemo_Stop(demo);
+
+    demo->ticdup = settings->ticdup > 0 ? settings->ticdup : 1;
+    demo->lowres_turn = settings->lowres_turn;
+    memset(demo->cmds, 0, sizeof(demo->cmds));
+
+    //!
+    // @category net
+    // @arg <x>
+    //
+    // When running a server, record each game as a demo named x.lmp
+    // (x-1.lmp and so on for later games).  Only Doom games with up to
+    // four players can be recorded this way.
+    //
+
+    demo->demo = OpenRecordFile("-svdemo", ".lmp");
+
+    if (demo->demo != NULL
+     && !WriteDemoHeader(demo, mission, settings, playeringame))
+    {
+        fclose(demo->demo);
+        demo->demo = NULL;
+    }
+
+    //!
+    // @category net
+    // @arg <x>
+    //
+    // When running a server, write the ticcmds of every player to
+    // x.tics as the game runs, in an append-only format that can be
+    // followed while it is being written.
+    //
+
+    demo->stream = OpenRecordFile("-svstream", ".tics");
+
+    if (demo->stream != NULL)
+    {
+        fwrite(NET_SVSTREAM_MAGIC, 1, strlen(NET_SVSTREAM_MAGIC),
+               demo->stream);
+
+        packet = NET_NewPacket(64);
+        NET_WriteSettings(packet, settings);
+        NET_WriteInt8(packet, mission);
+        NET_WriteInt8(packet, mode);
+        WriteStreamRecord(demo, NET_SVSTREAM_SETTINGS, packet);
+        NET_FreePacket(packet);
+    }
+}
+
+void NET_SVDemo_WriteTic(net_svdemo_t *demo, net_full_ticcmd_t *cmd)
+{
+    net_packet_t *packet;
+    int i;
+
+    if (demo->demo == NULL && demo->stream == NULL)
+    {
+        return;
+    }
+
+    // A vanilla demo has no way to remove a player from the game.  The
+    // clients stop recording when one leaves (see PlayerQuitGame), so do
+    // the same here, before the first tic the player is missing from.
+    // The tic stream carries on.
+
+    for (i = 0; i < DEMO_MAXPLAYERS && demo->demo != NULL; ++i)
+    {
+        if (demo->demo_playeringame[i] && !cmd->playeringame[i])
+        {
+            EndDemo(demo);
+        }
+    }
+
+    if (demo->demo != NULL)
+    {
+        for (i = 0; i < DEMO_MAXPLAYERS; ++i)
+        {
+            if (cmd->playeringame[i])
+            {
+                NET_TiccmdPatch(&demo->cmds[i], &cmd->cmds[i],
+                                &demo->cmds[i]);
+            }
+        }
+
+        WriteDemoTic(demo);
+    }
+
+    if (demo->stream != NULL)
+    {
+        packet = NET_NewPacket(64);
+        NET_WriteFullTiccmd(packet, cmd, demo->lowres_turn);
+        WriteStreamRecord(demo, NET_SVSTREAM_TIC, packet);
+        NET_FreePacket(packet);
+    }
+}
+
+void NET_SVDemo_Stop(net_svdemo_t *demo)
+{
+    EndDemo(demo);
+
+    if (demo->stream != NULL)
+    {
+        WriteStreamRecord(demo, NET_SVSTREAM_END, NULL);
+        fclose(demo->stream);
+        demo->stream = NULL;
+    }
+}
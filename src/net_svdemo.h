@@ -0,0 +1,64 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// Server-side demo recording
+//
+
+#ifndef NET_SVDEMO_H
+#define NET_SVDEMO_H
+
+#include <stdio.h>
+
+#include "d_mode.h"
+#include "net_defs.h"
+
+// The tic stream written with -svstream is a sequence of records, each
+// a 16-bit big-endian length, a type byte and a payload.  Records are
+// only ever appended, and each is written whole before being flushed,
+// so a spectator can follow the file while the game is running and
+// stop at the first record that is not complete yet.
+
+#define NET_SVSTREAM_MAGIC "CRISPYTICS1"
+
+typedef enum
+{
+    // Payload as NET_WriteSettings, followed by the mission and mode
+    // as bytes.  Always the first record.
+    NET_SVSTREAM_SETTINGS,
+
+    // One tic for every player, as NET_WriteFullTiccmd.  The diffs are
+    // against each player's previous ticcmd in the stream.
+    NET_SVSTREAM_TIC,
+
+    // The game has ended.  No payload.
+    NET_SVSTREAM_END,
+} net_svstream_record_t;
+
+typedef struct
+{
+    FILE *demo;
+    FILE *stream;
+    boolean longtics;
+    int ticdup;
+    boolean lowres_turn;
+    boolean demo_playeringame[NET_MAXPLAYERS];
+    ticcmd_t cmds[NET_MAXPLAYERS];
+} net_svdemo_t;
+
+void NET_SVDemo_Start(net_svdemo_t *demo, GameMission_t mission,
+                      GameMode_t mode, net_gamesettings_t *settings,
+                      boolean *playeringame);
+void NET_SVDemo_WriteTic(net_svdemo_t *demo, net_full_ticcmd_t *cmd);
+void NET_SVDemo_Stop(net_svdemo_t *demo);
+
+#endif /* #ifndef NET_SVDEMO_H */
@@ -57,7 +57,8 @@ static int *controls[] = { &key_left, &key_right, &key_up, &key_down,
                            &key_arti_blastradius, &key_arti_teleport,
                            &key_arti_teleportother, &key_arti_egg,
                            &key_arti_invulnerability,
-                           &key_prevweapon, &key_nextweapon, &key_demospeed, NULL };
+                           &key_prevweapon, &key_nextweapon, &key_demospeed,
+                           &key_demoseekback, &key_demoseekforward, NULL };
 
 static int *menu_nav[] = { &key_menu_activate, &key_menu_up, &key_menu_down,
                            &key_menu_left, &key_menu_right, &key_menu_back,
@@ -387,6 +388,12 @@ static void OtherKeysDialog(TXT_UNCAST_ARG(widget), TXT_UNCAST_ARG(unused))
     AddKeyControl(table, "Finish recording demo", &key_demo_quit);
     AddKeyControl(table, "Fast-forward demo",     &key_demospeed);
 
+    if (gamemission == doom)
+    {
+        AddKeyControl(table, "Seek demo backward",    &key_demoseekback);
+        AddKeyControl(table, "Seek demo forward",     &key_demoseekforward);
+    }
+
     AddSectionLabel(table, "Map", true);
     AddKeyControl(table, "Toggle map",            &key_map_toggle);
     AddKeyControl(table, "Zoom in",               &key_map_zoomin);
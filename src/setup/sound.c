@@ -60,10 +60,12 @@ int snd_sfxdevice = SNDDEVICE_SB;
 int snd_musicdevice = SNDDEVICE_SB;
 int snd_samplerate = 44100;
 int opl_io_port = 0x388;
+int opl_render_thread = 0;
 int snd_cachesize = 64 * 1024 * 1024;
 int snd_maxslicetime_ms = 28;
 char *snd_musiccmd = "";
 int snd_pitchshift = 0;
+int snd_spatial = 0;
 char *snd_dmxoption = "-opl3"; // [crispy] default to OPL3 emulation
 
 static int numChannels = 8;
@@ -281,6 +283,11 @@ void ConfigSound(TXT_UNCAST_ARG(widget), void *user_data)
                     TXT_NewStrut(4, 0),
                     TXT_NewCheckBox("Pitch-shifted sounds", &snd_pitchshift),
                     NULL))),
+        TXT_NewConditional(&snd_sfxdevice, SNDDEVICE_SB,
+            TXT_NewHorizBox(
+                TXT_NewStrut(4, 0),
+                TXT_NewCheckBox("Smooth positional sound", &snd_spatial),
+                NULL)),
         TXT_If(gamemission == strife,
             TXT_NewConditional(&snd_sfxdevice, SNDDEVICE_SB,
                 TXT_NewHorizBox(
@@ -394,8 +401,10 @@ void BindSoundVariables(void)
 
     M_BindIntVariable("snd_cachesize",            &snd_cachesize);
     M_BindIntVariable("opl_io_port",              &opl_io_port);
+    M_BindIntVariable("opl_render_thread",        &opl_render_thread);
 
     M_BindIntVariable("snd_pitchshift",           &snd_pitchshift);
+    M_BindIntVariable("snd_spatial",              &snd_spatial);
 
     if (gamemission == strife)
     {